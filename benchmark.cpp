@@ -5,16 +5,39 @@
 #include <mongo/client/dbclient.h>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <queue>
+#include <deque>
+#include <cmath>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/posix_time/posix_time_duration.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/signals2/mutex.hpp>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/program_options.hpp>
 
 #ifndef _WIN32
 #include <cxxabi.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sys/prctl.h>
 #endif
 
 using namespace std;
@@ -22,10 +45,227 @@ using namespace mongo;
 
 
 namespace {
-    const int thread_nums[] = {10, 20, 50, 100, 250, 500};
+    const int thread_nums[] = {1, 10, 20, 50, 100, 250, 500};
     const int max_threads = 501;
-    // Global connections
-    DBClientConnection _conn[max_threads];
+
+    // One T per thread, each far enough from the next that threads updating
+    // their own don't keep taking cache lines from each other.
+    template <typename T>
+    class PerThread {
+    public:
+        PerThread() { clear(); }
+
+        T& operator[](int threadId) { return slots[threadId].value; }
+
+        void clear() {
+            for (int i=0; i < max_threads; i++)
+                slots[i].value = T();
+        }
+
+    private:
+        struct Slot {
+            T value;
+            char pad[64];
+        };
+        Slot slots[max_threads];
+    };
+
+    // Cheap clock for the per-operation hot loop. Reads the TSC when the CPU
+    // says it ticks at a constant rate, calibrated against CLOCK_MONOTONIC at
+    // startup, and otherwise CLOCK_MONOTONIC itself (a vDSO call on linux).
+    struct FastClock {
+        static void calibrate() {
+            useTsc = tscIsStable();
+            if (!useTsc) {
+                ticksPerMicro = 1000; // ticks are monotonic nanos
+                return;
+            }
+            long long n0 = monotonicNanos(), t0 = ticks();
+            usleep(50 * 1000);
+            long long n1 = monotonicNanos(), t1 = ticks();
+            ticksPerMicro = (t1 - t0) / ((n1 - n0) / 1000.0);
+        }
+
+        static long long ticks() {
+#if defined(__i386__) || defined(__x86_64__)
+            if (useTsc) {
+                unsigned lo, hi;
+                __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+                return ((long long)hi << 32) | lo;
+            }
+#endif
+            return monotonicNanos();
+        }
+
+        static long long toMicros(long long ticks) { return (long long)(ticks / ticksPerMicro); }
+        static long long fromMicros(long long micros) { return (long long)(micros * ticksPerMicro); }
+        static long long micros() { return toMicros(ticks()); }
+        static const char* source() { return useTsc ? "tsc" : "monotonic"; }
+
+    private:
+        static long long monotonicNanos() {
+#ifdef __APPLE__
+            timeval tv;
+            gettimeofday(&tv, 0);
+            return tv.tv_sec * 1000000000LL + tv.tv_usec * 1000LL;
+#else
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+        }
+
+        static bool tscIsStable() {
+#if defined(__i386__) || defined(__x86_64__)
+            ifstream cpuinfo("/proc/cpuinfo");
+            string line;
+            while (getline(cpuinfo, line)) {
+                if (line.compare(0, 5, "flags") == 0)
+                    return line.find(" constant_tsc") != string::npos && line.find(" nonstop_tsc") != string::npos;
+            }
+#endif
+            return false;
+        }
+
+        static bool useTsc;
+        static double ticksPerMicro;
+    };
+    bool FastClock::useTsc = false;
+    double FastClock::ticksPerMicro = 1000;
+
+    // Where the time of one operation went. Everything before the first
+    // message goes out is encode; time between and after round trips is decode.
+    struct Phases {
+        Phases() : samples(0), encode(0), send(0), wait(0), receive(0), decode(0) {}
+
+        void add(const Phases& other) {
+            samples += other.samples;
+            encode += other.encode;
+            send += other.send;
+            wait += other.wait;
+            receive += other.receive;
+            decode += other.decode;
+        }
+
+        void appendTo(BSONObjBuilder& b) const {
+            const double n = samples ? samples : 1;
+            b.append("samples", samples);
+            b.append("encode_micros", encode / n);
+            b.append("send_micros", send / n);
+            b.append("wait_micros", wait / n);
+            b.append("receive_micros", receive / n);
+            b.append("decode_micros", decode / n);
+        }
+
+        long long samples;
+        long long encode;
+        long long send;
+        long long wait;     // until the reply header arrives
+        long long receive;  // rest of the reply
+        long long decode;
+    };
+
+    // Times the wire round trips of sampled operations. Unsampled operations
+    // go straight to DBClientConnection.
+    class PhaseTimedConnection : public DBClientConnection {
+    public:
+        PhaseTimedConnection() : sampling(false) {}
+
+        void beginSample(long long opStart) {
+            sampling = true;
+            start = opStart;
+            firstSend = 0;
+            current = Phases();
+        }
+
+        void endSample(long long opEnd, Phases& out) {
+            sampling = false;
+            current.samples = 1;
+            current.encode = (firstSend ? firstSend : opEnd) - start;
+            current.decode = max(0LL, opEnd - start - current.encode - current.send - current.wait - current.receive);
+            out.add(current);
+        }
+
+        // the operation threw, whatever was timed so far is meaningless
+        void cancelSample() {
+            sampling = false;
+        }
+
+        virtual void say(Message& toSend, bool isRetry = false) {
+            if (!sampling) {
+                DBClientConnection::say(toSend, isRetry);
+                return;
+            }
+            long long t0 = FastClock::micros();
+            if (!firstSend) firstSend = t0;
+            DBClientConnection::say(toSend, isRetry);
+            current.send += FastClock::micros() - t0;
+        }
+
+        virtual bool call(Message& toSend, Message& response, bool assertOk = true, string* actualServer = 0) {
+            if (!sampling)
+                return DBClientConnection::call(toSend, response, assertOk, actualServer);
+
+            // same as MessagingPort::call, but reads the header on its own so
+            // waiting on the server is split from receiving the reply
+            try {
+                long long t0 = FastClock::micros();
+                if (!firstSend) firstSend = t0;
+                port().say(toSend);
+                long long t1 = FastClock::micros();
+                current.send += t1 - t0;
+
+                while (true) {
+                    int len;
+                    port().recv(reinterpret_cast<char*>(&len), sizeof(len));
+                    long long t2 = FastClock::micros();
+
+                    char* buf = static_cast<char*>(malloc(len));
+                    memcpy(buf, &len, sizeof(len));
+                    port().recv(buf + sizeof(len), len - sizeof(len));
+                    response.setData(reinterpret_cast<MsgData*>(buf), true);
+                    long long t3 = FastClock::micros();
+
+                    current.wait += t2 - t1;
+                    current.receive += t3 - t2;
+
+                    if (response.header()->responseTo == toSend.header()->id)
+                        break;
+                    // a reply to an earlier message, keep waiting for ours
+                    response.reset();
+                    t1 = t3;
+                }
+            }
+            catch (SocketException&) {
+                failed = true;
+                sampling = false;
+                throw;
+            }
+            return true;
+        }
+
+    private:
+        bool sampling;
+        long long start;
+        long long firstSend;
+        Phases current;
+    };
+
+    // Global connections, one set per server under test. _conn points at
+    // the set in use; only A/B comparisons (--ab) switch it.
+    const int max_targets = 4;
+    PhaseTimedConnection _conns[max_targets][max_threads];
+    PhaseTimedConnection* _conn = _conns[0];
+    int current_target = 0;
+
+    // one more connection per target for explains, so the workers' own
+    // connections are left exactly as the test had them
+    DBClientConnection _side[max_targets];
+
+    void useTarget(int target) {
+        current_target = target;
+        _conn = _conns[target];
+    }
 
     bool multi_db = false;
 
@@ -60,7 +300,7 @@ namespace {
         }
         else {
             for (int t=0; t<max_threads; t++) {
-                insert(t, obj);
+                insert(t, ns, obj);
             }
         }
     }
@@ -89,6 +329,27 @@ namespace {
         }
     }
 
+    // the interesting part of an explain(), without the index bounds
+    BSONObj explain(const string& ns, Query q) {
+        BSONObj e = _side[current_target].findOne(ns, q.explain());
+        const char* fields[] = {"cursor", "nscanned", "nscannedObjects", "n", "millis"};
+        BSONObjBuilder b;
+        BOOST_FOREACH(const char* field, fields){
+            if (!e[field].eoo())
+                b.append(e[field]);
+        }
+        return b.obj();
+    }
+
+    // runCommand only says it failed in its return value; throwing lets
+    // the worker loops count a failed command like any other failed op
+    BSONObj command(DBClientConnection& conn, const string& db, const BSONObj& cmd) {
+        BSONObj info;
+        if (!conn.runCommand(db, cmd, info))
+            throw UserException(info["code"].numberInt(), string(cmd.firstElement().fieldName()) + " failed: " + info["errmsg"].str());
+        return info;
+    }
+
     void getLastError(int thread=-1) {
         if (thread != -1){
             _conn[thread].getLastError();
@@ -99,816 +360,2056 @@ namespace {
             getLastError(t);
     }
 
+    // makes document i of a data set
+    typedef BSONObj (*MakeDoc)(long long i);
 
-    // passed in as argument
-    int seconds;
-    // protect iterations with _mutex
-    boost::signals2::mutex _mutex;
-    int iterations;
+    void loadRange(const string& ns, MakeDoc makeDoc, int thread, long long first, long long last) {
+        vector<BSONObj> batch;
+        for (long long i=first; i < last; i++){
+            batch.push_back(makeDoc(i));
+            if (batch.size() == 1000 || i == last - 1) {
+                _conn[thread].insert(ns, batch);
+                batch.clear();
+            }
+        }
+        getLastError(thread);
+    }
 
-    struct TestBase{
-        virtual void run(int threadId, int seconds) = 0;
-        virtual void reset() = 0;
-        virtual string name() = 0;
-        virtual ~TestBase() {}
-    };
+    // Fills ns with makeDoc(0) .. makeDoc(n-1) the first time a test on the
+    // current target asks for it. Loading the big data sets takes a while,
+    // so a collection left by an earlier run with n documents is kept.
+    void loadOnce(const string& ns, long long n, MakeDoc makeDoc, int loaders = 1) {
+        static set<string> loaded[max_targets];
+        if (loaded[current_target].count(ns)) return;
 
-    template <typename T>
-    struct Test: TestBase{
-        virtual void run(int threadId, int seconds) {
-            test.run(threadId, seconds);
-            getLastError(threadId); //wait for operation to complete
-        }
-        virtual void reset(){
-            test.reset();
+        if ((long long)_conn[0].count(ns) != n) {
+            cerr << "loading " << n << " documents into " << ns << endl;
+            _conn[0].dropCollection(ns);
+            boost::thread_group threads;
+            for (int t=0; t < loaders; t++)
+                threads.create_thread(boost::bind(&loadRange, ns, makeDoc, t + 1, n * t / loaders, n * (t + 1) / loaders));
+            threads.join_all();
         }
+        loaded[current_target].insert(ns);
+    }
 
-        virtual string name(){
-            //from mongo::regression::demangleName()
-#ifdef _WIN32
-            return typeid(T).name();
-#else
-            int status;
 
-            char * niceName = abi::__cxa_demangle(typeid(T).name(), 0, 0, &status);
-            if ( ! niceName )
-                return typeid(T).name();
+    // Log-linear histogram of per-operation latencies in micros. Each power of
+    // two is split into 16 sub-buckets so percentiles are within ~6%.
+    struct LatencyHistogram {
+        enum { subBits = 4, subBuckets = 1 << subBits, nBuckets = (64 - subBits) * subBuckets };
 
-            string s = niceName;
-            free(niceName);
-            return s;
-#endif
+        LatencyHistogram() { clear(); }
+
+        void clear() {
+            memset(counts, 0, sizeof(counts));
+            total = 0;
+            sum = 0;
+            maxMicros = 0;
         }
 
-        T test;
-    };
+        void record(long long micros) {
+            if (micros < 0) micros = 0;
+            counts[bucket(micros)]++;
+            total++;
+            sum += micros;
+            if (micros > maxMicros) maxMicros = micros;
+        }
 
-    struct TestSuite{
-            template <typename T>
-            void add(){
-                tests.push_back(new Test<T>());
-            }
-            void run(){
-                for (vector<TestBase*>::iterator it=tests.begin(), end=tests.end(); it != end; ++it){
-                    TestBase* test = *it;
-                    boost::posix_time::ptime startTime, endTime; //reused
+        void merge(const LatencyHistogram& other) {
+            for (int i=0; i < nBuckets; i++)
+                counts[i] += other.counts[i];
+            total += other.total;
+            sum += other.sum;
+            maxMicros = max(maxMicros, other.maxMicros);
+        }
 
-                    cerr << "########## " << test->name() << " ##########" << endl;
+        // what was recorded after `earlier`, an older copy of this
+        // histogram; the max is only known to within its bucket
+        LatencyHistogram since(const LatencyHistogram& earlier) const {
+            LatencyHistogram h;
+            for (int i=0; i < nBuckets; i++) {
+                h.counts[i] = counts[i] - earlier.counts[i];
+                if (h.counts[i])
+                    h.maxMicros = min(maxMicros, midpoint(i));
+            }
+            h.total = total - earlier.total;
+            h.sum = sum - earlier.sum;
+            return h;
+        }
 
-                    BSONObjBuilder results;
+        // p in [0, 1]
+        long long percentile(double p) const {
+            if (!total) return 0;
+            long long rank = (long long)(p * total + 0.5);
+            rank = max(1LL, min(total, rank));
+            long long seen = 0;
+            for (int i=0; i < nBuckets; i++) {
+                seen += counts[i];
+                if (seen >= rank)
+                    return min(maxMicros, midpoint(i));
+            }
+            return maxMicros;
+        }
 
-                    double one_micros;
-                    iterations = 0;
-                    BOOST_FOREACH(int nthreads, thread_nums){
-                        test->reset();
-                        startTime = boost::posix_time::microsec_clock::universal_time();
-                        launch_subthreads(nthreads, test, seconds);
-                        endTime = boost::posix_time::microsec_clock::universal_time();
-                        double micros = (endTime-startTime).total_microseconds() / 1000001.0;
-
-                        if (nthreads == 1)
-                            one_micros = micros;
-
-                        results.append(BSONObjBuilder::numStr(nthreads),
-                                       BSON( "time" << micros
-                                          << "ops" << iterations
-                                          << "ops_per_sec" << iterations / micros
-                                          << "speedup" << one_micros / micros
-                                          ));
-                    }
+        void appendTo(BSONObjBuilder& b) const {
+            b.append("p50_micros", percentile(0.50));
+            b.append("p90_micros", percentile(0.90));
+            b.append("p99_micros", percentile(0.99));
+            b.append("p999_micros", percentile(0.999));
+            b.append("max_micros", maxMicros);
+            b.append("mean_micros", total ? double(sum) / total : 0.0);
+        }
 
-                    BSONObj out =
-                        BSON( "name" << test->name()
-                           << "results" << results.obj()
-                           );
-                    cout << out.jsonString(Strict) << endl;
-                }
-            }
-        private:
-            vector<TestBase*> tests;
+        long long counts[nBuckets];
+        long long total;
+        long long sum;
+        long long maxMicros;
 
-            void launch_subthreads(int threadId, TestBase* test, int seconds) {
-                if (!threadId) return;
+    private:
+        static int bucket(long long v) {
+            if (v < subBuckets) return v;
+            int shift = (63 - __builtin_clzll(v)) - subBits;
+            return (shift + 1) * subBuckets + int((v >> shift) - subBuckets);
+        }
+        static long long midpoint(int i) {
+            if (i < subBuckets) return i;
+            int shift = i / subBuckets - 1;
+            long long mantissa = i % subBuckets + subBuckets;
+            return (mantissa << shift) + ((1LL << shift) >> 1);
+        }
+    };
 
-                boost::thread athread(boost::bind(&TestBase::run, test, threadId, seconds));
+    // Operations that threw instead of completing. Timeouts are counted in
+    // errors too; reconnects are failed connections that were replaced.
+    struct Failures {
+        Failures() : errors(0), timeouts(0), reconnects(0) {}
 
-                launch_subthreads(threadId - 1, test, seconds);
+        void add(const Failures& other) {
+            errors += other.errors;
+            timeouts += other.timeouts;
+            reconnects += other.reconnects;
+            latencies.merge(other.latencies);
+        }
 
-                athread.join();
+        void appendTo(BSONObjBuilder& b, long long ops) const {
+            b.append("errors", errors);
+            b.append("timeouts", timeouts);
+            b.append("reconnects", reconnects);
+            b.append("error_rate", errors ? double(errors) / (ops + errors) : 0.0);
+            if (errors) {
+                BSONObjBuilder f;
+                latencies.appendTo(f);
+                b.append("failed", f.obj());
             }
-    };
-
-/*
-    void clearDB(){
-        for (int i=0; i<max_threads; i++) {
-            _conn[0].dropDatabase(_db + BSONObjBuilder::numStr(i));
-            _conn[0].getLastError();
-            if (!multi_db)
-                return;
         }
-    }
-    */
-}
 
-/*
-namespace Overhead{
-    // this tests the overhead of the system
-    struct DoNothing{
-        void run(int t, int n) {}
-        void reset(){ clearDB(); }
+        long long errors;
+        long long timeouts;
+        long long reconnects;
+        LatencyHistogram latencies;
     };
-}
 
-namespace Insert{
-    struct Base{
-        void reset(){ clearDB(); }
-    };
+    // How many results each operation came back with, kept per thread and
+    // summed into "<name>", "<name>_per_op" and "<name>_max" once they're done.
+    class ResultCounts {
+    public:
+        void clear() { counts.clear(); }
 
-    struct Empty : Base{
-        void run(int t, int n) {
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSONObj());
-            }
+        void add(int threadId, long long n) {
+            Counts& c = counts[threadId];
+            c.results += n;
+            c.ops++;
+            c.most = max(c.most, n);
         }
-    };
 
-    template <int BatchSize>
-    struct EmptyBatched : Base{
-        void run(int t, int n) {
-            for (int i=0; i < seconds / BatchSize / n; i++){
-                vector<BSONObj> objs(BatchSize);
-                insert(t, objs);
+        void appendTo(BSONObjBuilder& b, const string& name) {
+            long long total = 0, ops = 0, most = 0;
+            for (int i=0; i < max_threads; i++){
+                total += counts[i].results;
+                ops += counts[i].ops;
+                most = max(most, counts[i].most);
             }
+            b.append(name, total);
+            b.append(name + "_per_op", ops ? double(total) / ops : 0.0);
+            b.append(name + "_max", most);
         }
+
+    private:
+        struct Counts {
+            Counts() : results(0), ops(0), most(0) {}
+            long long results;
+            long long ops;
+            long long most;
+        };
+
+        PerThread<Counts> counts;
     };
 
-    struct EmptyCapped : Base{
-        void run(int t, int n) {
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSONObj());
+    // passed in as argument
+    string host;
+    vector<string> targets; // host first, then each --ab
+    int ab_pairs = 5;
+    int ab_seconds = 2;
+    int seconds;
+    bool adaptive_sweep = false;
+    int slo_p99_micros = 10000;
+    int sessions = 0;
+    int session_threads = 50;
+    int think_ms = 1000;
+    int phase_sample = 100;
+    double harness_overhead_ns = 0; // per SimpleTest iteration, measured at startup
+    string soak_test;
+    double soak_hours = 8;
+    int soak_threads = 100;
+    int checkpoint_secs = 60;
+    long long ram_mb = 0;
+    string restart_cmd;
+    int op_timeout_ms = 0; // 0 waits forever
+    int flush_millis = 1000; // how often SimpleTest threads publish their counts
+    // protect iterations, bytes, latencies, phases and failures with _mutex
+    boost::signals2::mutex _mutex;
+    long long iterations; // tens of millions a second in the overhead suite
+    long long bytes; // payload moved, for tests that report it
+    LatencyHistogram latencies;
+    Phases phases;
+    Failures failures;
+
+    // --trace-file: every Nth operation of each SimpleTest thread goes into
+    // that thread's ring, which only that thread writes while the round
+    // runs. After the round the rings are written out as Chrome trace
+    // events (chrome://tracing or ui.perfetto.dev), one process per round
+    // and one track per connection.
+    struct Tracer {
+        struct Event {
+            long long start;
+            long long end;
+            int conn; // differs from the thread under --pool
+            bool failed;
+        };
+
+        struct Ring {
+            Ring() : count(0) {}
+            vector<Event> events;
+            long long count;
+        };
+
+        enum { ringSize = 4096 }; // most recent events kept per thread
+
+        Tracer() : sample(0), rounds(0) {}
+
+        void open(const string& path, int everyNth) {
+            out.open(path.c_str());
+            if (!out) {
+                cerr << "couldn't open trace file " << path << endl;
+                return;
             }
+            sample = max(1, everyNth);
+            origin = FastClock::ticks();
+            rings.resize(max_threads);
+            for (int i=0; i < max_threads; i++)
+                rings[i].events.resize(ringSize);
+            out << "{\"traceEvents\":[" << endl;
         }
-        void reset(){
-            clearDB();
-            for (int t=0; t<max_threads; t++){
-                _conn[t].createCollection(ns[t], 32 * 1024, true);
-                if (!multi_db)
-                    return;
-            }
+
+        // called from the worker loop, so nothing here may block
+        void record(int threadId, int conn, long long start, long long end, bool failed) {
+            Ring& r = rings[threadId];
+            Event& e = r.events[r.count++ % ringSize];
+            e.start = start;
+            e.end = end;
+            e.conn = conn;
+            e.failed = failed;
         }
-    };
 
-    struct JustID : Base{
-        void run(int t, int n) {
-            for (int i=0; i < seconds / n; i++){
-                BSONObjBuilder b;
-                b << GENOID;
-                insert(t, b.obj());
+        void writeRound(const string& name, int nthreads) {
+            const int pid = ++rounds;
+            out << (pid > 1 ? "," : "")
+                << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"args\":{\"name\":\"" << name << " " << nthreads << " threads\"}}" << endl;
+            for (int t=0; t < max_threads; t++){
+                Ring& r = rings[t];
+                for (long long i=max(0LL, r.count - ringSize); i < r.count; i++){
+                    const Event& e = r.events[i % ringSize];
+                    out << ",{\"name\":\"" << name << "\",\"cat\":\"" << (e.failed ? "failed" : "op")
+                        << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << t
+                        << ",\"ts\":" << FastClock::toMicros(e.start - origin)
+                        << ",\"dur\":" << FastClock::toMicros(e.end - e.start)
+                        << ",\"args\":{\"conn\":" << e.conn << ",\"target\":" << current_target << "}}" << endl;
+                }
+                r.count = 0;
             }
         }
-    };
 
-    struct IntID : Base{
-        void run(int t, int n) {
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSON("_id" << base + i));
-            }
+        void close() {
+            if (!sample) return;
+            out << "]}" << endl;
+            out.close();
         }
-    };
 
-    struct IntIDUpsert : Base{
-        void run(int t, int n) {
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                update(t, BSON("_id" << base + i), BSONObj(), true);
-            }
+        int sample; // 0 when not tracing
+        int rounds;
+        long long origin;
+        vector<Ring> rings;
+        ofstream out;
+    } tracer;
+
+    // --pool: workers borrow one of pool_conns connections for each
+    // operation instead of owning _conn[threadId], like request threads
+    // sharing an app server's pool. The free list is a Treiber stack of
+    // connection indexes; the head packs a tag above the index so a pop
+    // that raced another thread's pop and push of the same entry (ABA)
+    // fails its compare-and-swap instead of corrupting the list. Workers
+    // that find it empty spin briefly, then sleep until one is given back,
+    // so hundreds of them waiting don't eat the CPU the others need.
+    int pool_conns = 0; // 0: every thread has its own connection
+
+    class ConnectionPool {
+    public:
+        ConnectionPool() : head(0), waiters(0) {}
+
+        // connections 1..n, 0 marks the end of the list
+        void init(int n) {
+            head = 0;
+            for (int c=n; c >= 1; c--)
+                giveBack(c);
         }
-    };
 
-    struct JustNum : Base{
-        void run(int t, int n) {
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSON("x" << base + i));
+        int borrow() {
+            for (int spins=0; spins < 100; spins++){
+                if (int c = tryPop())
+                    return c;
             }
+            boost::mutex::scoped_lock lk(m);
+            // counted before looking again, so a giveBack that misses our
+            // last look still sees us waiting and wakes us
+            __sync_add_and_fetch(&waiters, 1);
+            int c;
+            while (!(c = tryPop()))
+                cv.wait(lk);
+            __sync_sub_and_fetch(&waiters, 1);
+            return c;
         }
-    };
 
-    struct JustNumIndexedBefore : Base{
-        void run(int t, int n) {
-            ensureIndex(t, BSON("x" << 1));
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSON("x" << base + i));
+        void giveBack(int c) {
+            while (true) {
+                unsigned long long h = head;
+                next[c] = int(h & 0xffffffff);
+                if (__sync_bool_compare_and_swap(&head, h, tag(h) | c))
+                    break;
+            }
+            if (waiters) {
+                boost::mutex::scoped_lock lk(m);
+                cv.notify_one();
             }
         }
-    };
 
-    struct JustNumIndexedAfter : Base{
-        void run(int t, int n) {
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                insert(t, BSON("x" << base + i));
+    private:
+        int tryPop() {
+            while (true) {
+                unsigned long long h = head;
+                int c = int(h & 0xffffffff);
+                if (!c)
+                    return 0;
+                if (__sync_bool_compare_and_swap(&head, h, tag(h) | next[c]))
+                    return c;
             }
-            ensureIndex(t, BSON("x" << 1));
         }
-    };
 
-    struct NumAndID : Base{
-        void run(int t, int n) {
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                BSONObjBuilder b;
-                b << GENOID;
-                b << "x" << base+i;
-                insert(t, b.obj());
-            }
+        // the next tag, shifted into place; wraps around harmlessly
+        static unsigned long long tag(unsigned long long h) {
+            return ((h >> 32) + 1) << 32;
         }
-    };
-}
 
-namespace Update{
-    struct Base{
-        void reset(){ clearDB(); }
+        volatile unsigned long long head;
+        volatile int next[max_threads];
+        volatile int waiters;
+        boost::mutex m;
+        boost::condition_variable cv;
+    } pool;
+
+    LatencyHistogram poolWaits; // protect with _mutex
+
+    // What each SimpleTest thread got done in the round, written once by
+    // that thread as it finishes. The gap is the longest stretch it went
+    // without completing an operation, from the start of the round to the
+    // end; a thread starved behind a lock shows up here even when the
+    // totals look fine.
+    struct ThreadStats {
+        ThreadStats() : ran(false), ops(0), maxMicros(0), longestGapMicros(0) {}
+        bool ran;
+        long long ops;
+        long long maxMicros;
+        long long longestGapMicros;
     };
+    ThreadStats threadStats[max_threads];
+    // set once just before a round's threads are launched, so a thread that
+    // was slow to get scheduled counts the delay as a stall
+    long long roundStartTicks;
+    // how long the round about to start runs, set before the test's reset()
+    // for tests that schedule something partway through it
+    int roundSeconds;
 
-    struct IncNoIndexUpsert : Base{
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)), 1);
-                }
+    long long median(vector<long long> v) {
+        if (v.empty()) return 0;
+        nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+        return v[v.size() / 2];
+    }
+
+    // min/median/max ops per thread, Jain's fairness index over them (1 when
+    // every thread did the same, 1/n when one thread did everything) and the
+    // worst latency and stall any thread saw
+    void appendFairness(BSONObjBuilder& b, int nthreads) {
+        vector<long long> ops, maxes;
+        double sum = 0, sumSquares = 0;
+        long long longestGap = 0;
+        int stalledThread = 0;
+        for (int t=1; t <= nthreads; t++){
+            const ThreadStats& s = threadStats[t];
+            if (!s.ran) continue;
+            ops.push_back(s.ops);
+            maxes.push_back(s.maxMicros);
+            sum += s.ops;
+            sumSquares += double(s.ops) * s.ops;
+            if (s.longestGapMicros > longestGap) {
+                longestGap = s.longestGapMicros;
+                stalledThread = t;
             }
         }
-    };
-    struct IncWithIndexUpsert : Base{
-        void reset(){ clearDB(); ensureIndex(-1, BSON("count" << 1));}
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)), 1);
+        if (ops.empty()) return;
+
+        BSONObjBuilder f;
+        f.append("threads", int(ops.size()));
+        f.append("ops_min", *min_element(ops.begin(), ops.end()));
+        f.append("ops_median", median(ops));
+        f.append("ops_max", *max_element(ops.begin(), ops.end()));
+        f.append("jain_index", sumSquares ? sum * sum / (ops.size() * sumSquares) : 1.0);
+        f.append("thread_max_micros_min", *min_element(maxes.begin(), maxes.end()));
+        f.append("thread_max_micros_median", median(maxes));
+        f.append("thread_max_micros_max", *max_element(maxes.begin(), maxes.end()));
+        f.append("longest_stall_micros", longestGap);
+        f.append("longest_stall_thread", stalledThread);
+        b.append("fairness", f.obj());
+    }
+
+    void reconnectAll() {
+        for (size_t t=0; t < targets.size(); t++){
+            for (int i=0; i < max_threads; i++){
+                string errmsg;
+                _conns[t][i].setSoTimeout(op_timeout_ms / 1000.0);
+                if ( ! _conns[t][i].connect( targets[t], errmsg ) ) {
+                    cout << "couldn't connect to " << targets[t] << " : " << errmsg << endl;
+                    exit(1);
                 }
             }
+            string errmsg;
+            if ( ! _side[t].connect( targets[t], errmsg ) ) {
+                cout << "couldn't connect to " << targets[t] << " : " << errmsg << endl;
+                exit(1);
+            }
         }
-    };
-    struct IncNoIndex : Base{
-        void reset(){
-            clearDB();
-            for (int i=0; i<100; i++)
-                insert(-1, BSON("_id" << i << "count" << 0));
-        }
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)));
-                }
+    }
+
+    // runs --restart-cmd and waits for the server to take connections again
+    void restartServer() {
+        cerr << "restarting server: " << restart_cmd << endl;
+        if (system(restart_cmd.c_str()) != 0)
+            cerr << "restart command failed" << endl;
+
+        for (int tries=0; ; tries++){
+            string errmsg;
+            DBClientConnection probe;
+            if (probe.connect(host, errmsg))
+                break;
+            if (tries == 120) {
+                cout << "server didn't come back after restart : " << errmsg << endl;
+                exit(1);
             }
+            sleep(1);
         }
-    };
-    struct IncWithIndex : Base{
-        void reset(){
-            clearDB();
-            ensureIndex(-1, BSON("count" << 1));
-            for (int i=0; i<100; i++)
-                insert(-1, BSON("_id" << i << "count" << 0));
+        reconnectAll();
+    }
+
+    // After an operation threw: replaces the connection if the driver gave
+    // up on it. Returns true if a new connection was made.
+    bool reconnectIfFailed(DBClientConnection& conn) {
+        if (!conn.isFailed())
+            return false;
+        string errmsg;
+        if (!conn.connect(targets[current_target], errmsg)) {
+            usleep(100 * 1000); // server is down, don't spin on it
+            return false;
         }
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)));
-                }
-            }
+        return true;
+    }
+
+    bool reconnectIfFailed(int threadId) {
+        return reconnectIfFailed(_conn[threadId]);
+    }
+
+    // empty when the server couldn't or wouldn't answer; mongos and
+    // mock_server leave out sections, so read them with getObjectField
+    BSONObj serverStatus() {
+        BSONObj info;
+        try {
+            if (!_conn[0].runCommand("admin", BSON("serverStatus" << 1), info))
+                return BSONObj();
         }
-    };
-    struct IncNoIndex_QueryOnSecondary : Base{
-        void reset(){
-            clearDB();
-            ensureIndex(-1, BSON("i" << 1));
-            for (int i=0; i<100; i++)
-                insert(-1, BSON("_id" << i << "i" << i << "count" << 0));
+        catch (DBException&) {
+            reconnectIfFailed(0);
+            return BSONObj();
         }
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("i" << i), BSON("$inc" << BSON("count" << 1)));
-                }
-            }
+        return info;
+    }
+
+    bool isTimeout(const SocketException& e) {
+        return e._type == SocketException::RECV_TIMEOUT || e._type == SocketException::SEND_TIMEOUT;
+    }
+
+    // Runs op; false if it threw, with timedOut set if the socket timed out.
+    // Every loop that keeps going after a failed operation runs it through here.
+    template <typename Op>
+    bool tryOp(Op op, bool& timedOut) {
+        timedOut = false;
+        try {
+            op();
+            return true;
         }
-    };
-    struct IncWithIndex_QueryOnSecondary : Base{
-        void reset(){
-            clearDB();
-            ensureIndex(-1, BSON("count" << 1));
-            ensureIndex(-1, BSON("i" << 1));
-            for (int i=0; i<100; i++)
-                insert(-1, BSON("_id" << i << "i" << i << "count" << 0));
+        catch (SocketException& e) {
+            timedOut = isTimeout(e);
         }
-        void run(int t, int n) {
-            const int incs = seconds/n/100;
-            for (int i=0; i<100; i++){
-                for (int j=0; j<incs; j++){
-                    update(t, BSON("i" << i), BSON("$inc" << BSON("count" << 1)));
-                }
-            }
+        catch (DBException&) {
         }
-    };
-}
+        return false;
+    }
 
-namespace Queries{
-    struct Empty{
-        void reset() {
-            clearDB();
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSONObj());
-            }
-            getLastError();
+    // Every loop that keeps going after an operation throws counts it here:
+    // its latency, whether it timed out, and a new connection if it took one.
+    void countFailure(Failures& failed, DBClientConnection& conn, long long micros, bool timedOut) {
+        // unsampled calls only see the driver's "transport error",
+        // so anything that failed after the full timeout was one
+        if (op_timeout_ms && micros >= op_timeout_ms * 1000LL)
+            timedOut = true;
+        failed.errors++;
+        if (timedOut)
+            failed.timeouts++;
+        failed.latencies.record(micros);
+        if (reconnectIfFailed(conn))
+            failed.reconnects++;
+    }
+
+    // Polls serverStatus on its own connection while a round runs, for the
+    // numbers that only mean something while the load is on: lock queue
+    // depth and resident memory.
+    struct ServerSampler {
+        ServerSampler() : running(false) {}
+
+        void start(int intervalMillis = 100) {
+            stop();
+            samples = 0;
+            queueSum = 0;
+            queueMax = readersMax = writersMax = 0;
+            residentMaxMb = 0;
+            interval = intervalMillis;
+            running = true;
+            thread.reset(new boost::thread(boost::bind(&ServerSampler::poll, this)));
         }
 
-        void run(int t, int n){
-            int chunk = seconds / n;
-            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
-            cursor->itcount();
+        void stop() {
+            running = false;
+            if (!thread) return;
+            thread->join();
+            thread.reset();
         }
-    };
 
-    struct HundredTableScans{
-        void reset() {
-            clearDB();
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSONObj());
-            }
-            getLastError();
+        void appendTo(BSONObjBuilder& b) const {
+            BSONObjBuilder s;
+            s.append("samples", samples);
+            s.append("queue_mean", samples ? double(queueSum) / samples : 0.0);
+            s.append("queue_max", queueMax);
+            s.append("queue_readers_max", readersMax);
+            s.append("queue_writers_max", writersMax);
+            s.append("resident_max_mb", residentMaxMb);
+            b.append("server", s.obj());
         }
 
-        void run(int t, int n){
-            for (int i=0; i < 100/n; i++){
-                findOne(t, BSON("does_not_exist" << i));
+        int samples;
+        long long queueSum;
+        int queueMax;
+        int readersMax;
+        int writersMax;
+        long long residentMaxMb;
+
+    private:
+        void poll() {
+            DBClientConnection conn;
+            string errmsg;
+            if (!conn.connect(targets[current_target], errmsg)) {
+                cerr << "sampler couldn't connect : " << errmsg << endl;
+                return;
+            }
+            while (running) {
+                try {
+                    BSONObj status;
+                    if (conn.runCommand("admin", BSON("serverStatus" << 1), status))
+                        sample(status);
+                }
+                catch (DBException& e) {
+                    // the round goes on without these numbers
+                    reconnectIfFailed(conn);
+                }
+                usleep(interval * 1000);
             }
         }
-    };
 
-    struct IntID{
-        void reset() {
-            clearDB();
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("_id" << i));
+        // mongos and mock_server leave out some of these
+        void sample(const BSONObj& status) {
+            BSONObj queue = status.getObjectField("globalLock").getObjectField("currentQueue");
+            if (!queue.isEmpty()) {
+                samples++;
+                queueSum += queue["total"].numberInt();
+                queueMax = max(queueMax, queue["total"].numberInt());
+                readersMax = max(readersMax, queue["readers"].numberInt());
+                writersMax = max(writersMax, queue["writers"].numberInt());
             }
-            getLastError();
+            BSONObj mem = status.getObjectField("mem");
+            if (mem.hasField("resident"))
+                residentMaxMb = max(residentMaxMb, mem["resident"].numberLong());
         }
 
-        void run(int t, int n){
-            int chunk = seconds / n;
-            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
-            cursor->itcount();
-        }
+        volatile bool running;
+        int interval;
+        boost::scoped_ptr<boost::thread> thread;
     };
 
-    struct IntIDRange{
-        void reset() {
-            clearDB();
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("_id" << i));
-            }
-            getLastError();
-        }
+    // Network conditions the proxy puts between the connections and the
+    // servers. Read for every chunk, so they can change between rounds.
+    struct NetEm {
+        NetEm() : enabled(false), rttMicros(0), jitterMicros(0), mbps(0), batchMicros(0) {}
 
-        void run(int t, int n){
-            int chunk = seconds / n;
-            auto_ptr<DBClientCursor> cursor = query(t, BSON("_id" << GTE << chunk*t << LT << chunk*(t+1)));
-            cursor->itcount();
+        void appendTo(BSONObjBuilder& b) const {
+            BSONObjBuilder n;
+            n.append("rtt_ms", rttMicros / 1000.0);
+            n.append("jitter_ms", jitterMicros / 1000.0);
+            n.append("mbps", mbps);
+            n.append("batch_micros", batchMicros);
+            b.append("netem", n.obj());
         }
-    };
 
-    struct IntIDFindOne{
-        void reset() {
-            clearDB();
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("_id" << i));
-            }
-            getLastError();
-        }
+        bool enabled;
+        volatile int rttMicros;
+        volatile int jitterMicros; // extra one-way delay, uniform in [0, jitter)
+        volatile double mbps;      // per direction of each connection, 0 for unlimited
+        volatile int batchMicros;  // data is released only on multiples of this
+    } netem;
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("_id" << base + i));
+    // TCP proxy in front of one server. Each connection gets a pipe per
+    // direction: a reader stamps every chunk with when it should arrive
+    // (after the wire is free, half the RTT, jitter and batching, never
+    // before the chunk ahead of it), and a writer sleeps until then.
+    class Proxy {
+    public:
+        // returns the local host:port to connect to instead of upstream
+        string start(const string& upstream) {
+            // runner.py passes just the port
+            string h = "127.0.0.1", port = upstream;
+            size_t colon = upstream.rfind(':');
+            if (colon != string::npos) {
+                h = upstream.substr(0, colon);
+                port = upstream.substr(colon + 1);
             }
-        }
-    };
+            else if (upstream.find_first_not_of("0123456789") != string::npos) {
+                h = upstream;
+                port = "27017";
+            }
+            addrinfo hints;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* res;
+            if (getaddrinfo(h.c_str(), port.c_str(), &hints, &res) != 0) {
+                cout << "proxy couldn't resolve " << upstream << endl;
+                exit(1);
+            }
+            memcpy(&server, res->ai_addr, sizeof(server));
+            freeaddrinfo(res);
 
-    struct IntNonID{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << i));
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t len = sizeof(addr);
+            if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 1024) != 0
+                    || getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+                cout << "proxy couldn't listen : " << strerror(errno) << endl;
+                exit(1);
             }
-            getLastError();
+            boost::thread(boost::bind(&Proxy::acceptLoop, this)).detach();
+            return "127.0.0.1:" + BSONObjBuilder::numStr(ntohs(addr.sin_port));
         }
 
-        void run(int t, int n){
-            int chunk = seconds / n;
-            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
-            cursor->itcount();
-        }
-    };
+    private:
+        // both sockets of one proxied connection, closed when all four pipe threads are done
+        struct Link {
+            Link(int c, int s) : client(c), server(s) {}
+            ~Link() { close(client); close(server); }
+            int client;
+            int server;
+        };
 
-    struct IntNonIDRange{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << i));
-            }
-            getLastError();
-        }
+        struct Pipe {
+            struct Chunk {
+                long long due;
+                string data;
+            };
 
-        void run(int t, int n){
-            int chunk = seconds / n;
-            auto_ptr<DBClientCursor> cursor = query(t, BSON("x" << GTE << chunk*t << LT << chunk*(t+1)));
-            cursor->itcount();
-        }
-    };
+            static const int spinMicros = 200;
 
-    struct IntNonIDFindOne{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << i));
-            }
-            getLastError();
-        }
+            Pipe(boost::shared_ptr<Link> l, int f, int t) : link(l), from(f), to(t), done(false), lastDue(0), wireFree(0), seed(f) {}
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("x" << base + i));
-            }
-        }
-    };
+            void read() {
+                vector<char> buf(64 * 1024);
+                while (true) {
+                    int n = ::recv(from, &buf[0], buf.size(), 0);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        break;
 
-    struct RegexPrefixFindOne{
-        RegexPrefixFindOne(){
-            for (int i=0; i<100; i++)
-                nums[i] = "^" + BSONObjBuilder::numStr(i+1);
-        }
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << BSONObjBuilder::numStr(i)));
-            }
-            getLastError();
-        }
+                    const long long now = FastClock::micros();
+                    long long due = now;
+                    if (netem.mbps > 0) {
+                        wireFree = max(wireFree, now) + (long long)(n * 8 / netem.mbps);
+                        due = wireFree;
+                    }
+                    due += netem.rttMicros / 2;
+                    if (netem.jitterMicros > 0)
+                        due += rand_r(&seed) % netem.jitterMicros;
+                    if (netem.batchMicros > 0)
+                        due = (due + netem.batchMicros - 1) / netem.batchMicros * netem.batchMicros;
+                    due = max(due, lastDue); // TCP doesn't reorder
+                    lastDue = due;
 
-        void run(int t, int n){
-            for (int i=0; i < seconds / n / 100; i++){
-                for (int j=0; j<100; j++){
-                    BSONObjBuilder b;
-                    b.appendRegex("x", nums[j]);
-                    findOne(t, b.obj());
+                    boost::mutex::scoped_lock lk(m);
+                    Chunk c;
+                    c.due = due;
+                    chunks.push_back(c);
+                    chunks.back().data.assign(&buf[0], n);
+                    cv.notify_one();
                 }
+                boost::mutex::scoped_lock lk(m);
+                done = true;
+                cv.notify_one();
             }
-        }
-        string nums[100];
-    };
 
-    struct TwoIntsBothGood{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            ensureIndex(-1, BSON("y" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << i << "y" << (seconds-i)));
+            void write() {
+#ifdef __linux__
+                // the default 50us of slack would swamp the shortest sweep points
+                prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+#endif
+                while (true) {
+                    Chunk c;
+                    {
+                        boost::mutex::scoped_lock lk(m);
+                        while (chunks.empty() && !done)
+                            cv.wait(lk);
+                        if (chunks.empty())
+                            break;
+                        c.due = chunks.front().due;
+                        c.data.swap(chunks.front().data);
+                        chunks.pop_front();
+                    }
+                    // sleep until close to due, then spin the rest: a sleep can
+                    // overshoot by tens of micros, more than a 100us round trip can take
+                    const long long wait = c.due - FastClock::micros();
+                    if (wait > spinMicros)
+                        usleep(wait - spinMicros);
+                    while (FastClock::micros() < c.due)
+                        ;
+
+                    const char* p = c.data.data();
+                    int left = c.data.size();
+                    while (left > 0) {
+                        int n = ::send(to, p, left, MSG_NOSIGNAL);
+                        if (n < 0 && errno == EINTR)
+                            continue;
+                        if (n <= 0) {
+                            ::shutdown(from, SHUT_RD); // the other end is gone, stop reading for it
+                            return;
+                        }
+                        p += n;
+                        left -= n;
+                    }
+                }
+                ::shutdown(to, SHUT_WR);
             }
-            getLastError();
-        }
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
-            for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("x" << base + i << "y" << (seconds-(base+i))));
+            boost::shared_ptr<Link> link;
+            int from;
+            int to;
+            boost::mutex m;
+            boost::condition_variable cv;
+            deque<Chunk> chunks;
+            bool done;
+            long long lastDue;  // reader thread only
+            long long wireFree; // reader thread only
+            unsigned seed;
+        };
+
+        void acceptLoop() {
+            int on = 1;
+            while (true) {
+                int client = accept(listener, 0, 0);
+                if (client < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    // out of descriptors (EMFILE) doesn't clear up by retrying at once
+                    cerr << "proxy couldn't accept : " << strerror(errno) << endl;
+                    usleep(100 * 1000);
+                    continue;
+                }
+                int upstream = socket(AF_INET, SOCK_STREAM, 0);
+                if (connect(upstream, reinterpret_cast<sockaddr*>(&server), sizeof(server)) != 0) {
+                    cerr << "proxy couldn't connect upstream : " << strerror(errno) << endl;
+                    close(client);
+                    close(upstream);
+                    continue;
+                }
+                // batching is emulated above, so don't let the kernel add its own
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                setsockopt(upstream, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+                boost::shared_ptr<Link> link(new Link(client, upstream));
+                boost::shared_ptr<Pipe> up(new Pipe(link, client, upstream));
+                boost::shared_ptr<Pipe> down(new Pipe(link, upstream, client));
+                boost::thread(boost::bind(&Pipe::read, up)).detach();
+                boost::thread(boost::bind(&Pipe::write, up)).detach();
+                boost::thread(boost::bind(&Pipe::read, down)).detach();
+                boost::thread(boost::bind(&Pipe::write, down)).detach();
             }
         }
+
+        int listener;
+        sockaddr_in server;
     };
 
-    struct TwoIntsFirstGood{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            ensureIndex(-1, BSON("y" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << i << "y" << (i%13)));
+    Proxy proxies[max_targets];
+
+    // Through the proxy each connection takes three descriptors in this
+    // process: the client's socket and both of the proxy's.
+    void raiseFileLimit(rlim_t wanted) {
+        rlimit files;
+        if (getrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur >= wanted)
+            return;
+        files.rlim_cur = (files.rlim_max == RLIM_INFINITY) ? wanted : min(wanted, files.rlim_max);
+        if (setrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur < wanted)
+            cerr << "warning: the proxy needs about " << wanted << " open files but the limit is "
+                 << files.rlim_cur << ", raise ulimit -n" << endl;
+    }
+
+    // round trip times for --rtt-sweep, in micros; 0 is the proxy's own
+    // cost, the baseline the others are read against
+    const int rtt_sweep[] = {0, 100, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+    bool rtt_sweep_on = false;
+    int rtt_threads = 50;
+
+    struct TestBase{
+        virtual void run(int threadId, int seconds) = 0;
+        virtual void reset() = 0;
+        // stops whatever reset started; runs once the workers are done,
+        // before report, on every path that runs the test
+        virtual void teardown() = 0;
+        virtual string name() = 0;
+        // test specific numbers for the round that just finished
+        virtual void report(BSONObjBuilder& round) = 0;
+        // the query to explain for this test, false if there is none
+        virtual bool explainQuery(string& ns, Query& q) = 0;
+        virtual ~TestBase() {}
+    };
+
+    template <typename T>
+    struct Test: TestBase{
+        virtual void run(int threadId, int seconds) {
+            test.run(threadId, seconds);
+            test.finish(threadId);
+        }
+        virtual void reset(){
+            test.reset();
+        }
+        virtual void teardown(){
+            test.teardown();
+        }
+        virtual void report(BSONObjBuilder& round){
+            test.report(round);
+        }
+        virtual bool explainQuery(string& ns, Query& q){
+            return test.explainQuery(ns, q);
+        }
+
+        virtual string name(){
+            //from mongo::regression::demangleName()
+#ifdef _WIN32
+            return typeid(T).name();
+#else
+            int status;
+
+            char * niceName = abi::__cxa_demangle(typeid(T).name(), 0, 0, &status);
+            if ( ! niceName )
+                return typeid(T).name();
+
+            string s = niceName;
+            free(niceName);
+            return s;
+#endif
+        }
+
+        T test;
+    };
+
+    struct TestSuite;
+
+    // suites selectable with --suite, filled in by the TestSuite constructor
+    map<string, TestSuite*>& suites() {
+        static map<string, TestSuite*> registered;
+        return registered;
+    }
+
+    struct TestSuite{
+            TestSuite(const string& name) {
+                suites()[name] = this;
             }
-            getLastError();
+            template <typename T>
+            void add(){
+                tests.push_back(new Test<T>());
+            }
+            void run(){
+                for (vector<TestBase*>::iterator it=tests.begin(), end=tests.end(); it != end; ++it){
+                    TestBase* test = *it;
+
+                    cerr << "########## " << test->name() << " ##########" << endl;
+
+                    // always start from a single thread so speedup has a baseline
+                    map<int, BSONObj> rounds;
+                    rounds[1] = runRound(test, 1);
+
+                    BSONObjBuilder knee;
+                    if (adaptive_sweep) {
+                        adaptiveSweep(test, rounds, knee);
+                    }
+                    else {
+                        BOOST_FOREACH(int nthreads, thread_nums){
+                            if (!rounds.count(nthreads))
+                                rounds[nthreads] = runRound(test, nthreads);
+                        }
+                    }
+
+                    const double one_ops_per_sec = rounds[1]["ops_per_sec"].number();
+                    BSONObjBuilder results;
+                    for (map<int, BSONObj>::iterator r=rounds.begin(); r != rounds.end(); ++r){
+                        BSONObjBuilder round;
+                        round.appendElements(r->second);
+                        round.append("speedup", one_ops_per_sec ? r->second["ops_per_sec"].number() / one_ops_per_sec : 0.0);
+                        results.append(BSONObjBuilder::numStr(r->first), round.obj());
+                    }
+
+                    BSONObjBuilder out;
+                    out.append("name", test->name());
+                    out.append("results", results.obj());
+                    if (adaptive_sweep)
+                        out.append("knee", knee.obj());
+                    cout << out.obj().jsonString(Strict) << endl;
+                }
+            }
+            TestBase* find(const string& name) {
+                BOOST_FOREACH(TestBase* test, tests){
+                    if (test->name() == name)
+                        return test;
+                }
+                return 0;
+            }
+
+            // Runs one test for --soak-hours, printing a checkpoint line
+            // every --checkpoint-secs as it goes rather than one line at the end.
+            void soak(TestBase* test) {
+                const int soakSeconds = int(soak_hours * 3600);
+                const int nthreads = min(soak_threads, max_threads - 1);
+                cerr << "########## soak " << test->name() << " " << nthreads << " threads "
+                     << soak_hours << " hours ##########" << endl;
+
+                iterations = 0;
+                bytes = 0;
+                latencies.clear();
+                phases = Phases();
+                failures = Failures();
+                roundSeconds = soakSeconds;
+                test->reset();
+
+                BSONObj firstMem = serverStatus().getObjectField("mem").getOwned();
+                BSONObj lastMem = firstMem;
+                const long long start = FastClock::micros();
+                long long last = start;
+                long long totalOps = 0;
+
+                roundStartTicks = FastClock::ticks();
+                boost::thread workers(boost::bind(&TestSuite::launch_subthreads, this, nthreads, test, soakSeconds));
+                for (int checkpoint=1; ; checkpoint++){
+                    bool done = workers.timed_join(boost::posix_time::seconds(checkpoint_secs));
+                    if (done)
+                        test->teardown();
+
+                    long long ops;
+                    LatencyHistogram interval;
+                    Failures failed;
+                    {
+                        boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+                        ops = iterations;
+                        interval = latencies;
+                        failed = failures;
+                        iterations = 0;
+                        latencies.clear();
+                        phases = Phases();
+                        failures = Failures();
+                    }
+                    const long long now = FastClock::micros();
+                    const double secs = (now - last) / 1000000.0;
+                    last = now;
+
+                    BSONObj mem = serverStatus().getObjectField("mem").getOwned();
+                    BSONObjBuilder memb;
+                    const char* fields[] = {"resident", "virtual", "mapped"};
+                    BOOST_FOREACH(const char* field, fields){
+                        if (!mem[field].isNumber())
+                            continue;
+                        memb.append(string(field) + "_mb", mem[field].numberLong());
+                        if (firstMem[field].isNumber())
+                            memb.append(string(field) + "_delta_mb", mem[field].numberLong() - firstMem[field].numberLong());
+                        if (lastMem[field].isNumber())
+                            memb.append(string(field) + "_step_mb", mem[field].numberLong() - lastMem[field].numberLong());
+                    }
+                    lastMem = mem;
+
+                    BSONObjBuilder b;
+                    b.append("name", test->name());
+                    b.append("checkpoint", checkpoint);
+                    b.append("threads", nthreads);
+                    b.append("elapsed", (now - start) / 1000000.0);
+                    b.append("ops", ops);
+                    b.append("ops_per_sec", secs ? ops / secs : 0.0);
+                    interval.appendTo(b);
+                    failed.appendTo(b, ops);
+                    b.append("mem", memb.obj());
+                    totalOps += ops;
+                    if (done) {
+                        // the test's own numbers cover the whole run
+                        iterations = totalOps;
+                        test->report(b);
+                    }
+                    cout << b.obj().jsonString(Strict) << endl;
+
+                    if (done)
+                        break;
+                }
+            }
+
+            // Runs every test at --rtt-threads through the proxy once per
+            // round trip time, slowest network last.
+            void rttSweep() {
+                const int nthreads = min(rtt_threads, max_threads - 1);
+                const int rtt = netem.rttMicros;
+                for (vector<TestBase*>::iterator it=tests.begin(), end=tests.end(); it != end; ++it){
+                    TestBase* test = *it;
+
+                    cerr << "########## " << test->name() << " RTT sweep ##########" << endl;
+
+                    BSONObjBuilder results;
+                    BOOST_FOREACH(int micros, rtt_sweep){
+                        netem.rttMicros = micros;
+                        results.append(BSONObjBuilder::numStr(micros), runRound(test, nthreads));
+                    }
+                    netem.rttMicros = rtt;
+
+                    BSONObj out =
+                        BSON( "name" << test->name()
+                           << "rtt_sweep" << nthreads
+                           << "results" << results.obj()
+                           );
+                    cout << out.jsonString(Strict) << endl;
+                }
+            }
+
+            // A/B mode: for every test and thread count, alternates short
+            // rounds between the targets (ABBA so neither always goes first)
+            // and reports each target's paired difference against the first.
+            void compare() {
+                const int ntargets = targets.size();
+                for (vector<TestBase*>::iterator it=tests.begin(), end=tests.end(); it != end; ++it){
+                    TestBase* test = *it;
+
+                    cerr << "########## " << test->name() << " A/B ##########" << endl;
+
+                    BSONObjBuilder results;
+                    BOOST_FOREACH(int nthreads, thread_nums){
+                        vector< vector<double> > ops(ntargets), p99(ntargets);
+                        vector<BSONObj> plans(ntargets);
+                        for (int pair=0; pair < ab_pairs; pair++){
+                            for (int k=0; k < ntargets; k++){
+                                int t = (pair % 2 == 0) ? k : ntargets - 1 - k;
+                                useTarget(t);
+                                BSONObj r = runRound(test, nthreads, ab_seconds);
+                                ops[t].push_back(r["ops_per_sec"].number());
+                                p99[t].push_back(r["p99_micros"].number());
+                                if (r["plan"].isABSONObj())
+                                    plans[t] = r["plan"].Obj().getOwned();
+                            }
+                        }
+                        useTarget(0);
+
+                        BSONObjBuilder round;
+                        for (int t=1; t < ntargets; t++){
+                            BSONObjBuilder diff;
+                            diff.append("ops_per_sec", pairedDiff(ops[0], ops[t]));
+                            diff.append("p99_micros", pairedDiff(p99[0], p99[t]));
+                            if (!plans[0].isEmpty() && planChanged(plans[0], plans[t])) {
+                                diff.append("plan_changed", true);
+                                diff.append("plan_a", plans[0]);
+                                diff.append("plan_b", plans[t]);
+                            }
+                            round.append(BSONObjBuilder::numStr(t), diff.obj());
+                        }
+                        results.append(BSONObjBuilder::numStr(nthreads), round.obj());
+                    }
+
+                    BSONObj out =
+                        BSON( "name" << test->name()
+                           << "ab" << targets
+                           << "pairs" << ab_pairs
+                           << "results" << results.obj()
+                           );
+                    cout << out.jsonString(Strict) << endl;
+                }
+            }
+
+        private:
+            vector<TestBase*> tests;
+
+            // the same index, scanning the same amount; millis is execution, not plan
+            static bool planChanged(const BSONObj& a, const BSONObj& b) {
+                const char* fields[] = {"cursor", "nscanned", "nscannedObjects", "n"};
+                BOOST_FOREACH(const char* field, fields){
+                    if (a[field].toString(false) != b[field].toString(false))
+                        return true;
+                }
+                return false;
+            }
+
+            // mean of b - a over paired rounds, with a 95% confidence interval
+            static BSONObj pairedDiff(const vector<double>& a, const vector<double>& b) {
+                // two-sided 97.5% quantiles of Student's t for 1..30 degrees of freedom
+                static const double t975[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                              2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                              2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+                const int n = a.size();
+                double meanA = 0, meanB = 0, meanD = 0;
+                for (int i=0; i < n; i++){
+                    meanA += a[i] / n;
+                    meanB += b[i] / n;
+                    meanD += (b[i] - a[i]) / n;
+                }
+                double var = 0;
+                for (int i=0; i < n; i++)
+                    var += (b[i] - a[i] - meanD) * (b[i] - a[i] - meanD);
+                double halfWidth = 0;
+                if (n > 1) {
+                    double t = (n - 1 <= 30) ? t975[n - 2] : 1.96;
+                    halfWidth = t * sqrt(var / (n - 1)) / sqrt(double(n));
+                }
+
+                BSONObjBuilder b2;
+                b2.append("a", meanA);
+                b2.append("b", meanB);
+                b2.append("diff", meanD);
+                b2.append("diff_pct", meanA ? 100 * meanD / meanA : 0.0);
+                b2.append("ci_low", meanD - halfWidth);
+                b2.append("ci_high", meanD + halfWidth);
+                b2.append("significant", n > 1 && (meanD - halfWidth > 0 || meanD + halfWidth < 0));
+                return b2.obj();
+            }
+
+            BSONObj runRound(TestBase* test, int nthreads, int secs = seconds) {
+                boost::posix_time::ptime startTime, endTime;
+
+                iterations = 0;
+                bytes = 0;
+                latencies.clear();
+                phases = Phases();
+                failures = Failures();
+                poolWaits.clear();
+                for (int t=0; t < max_threads; t++)
+                    threadStats[t] = ThreadStats();
+
+                roundSeconds = secs;
+                test->reset();
+                startTime = boost::posix_time::microsec_clock::universal_time();
+                roundStartTicks = FastClock::ticks();
+                launch_subthreads(nthreads, test, secs);
+                if (pool_conns) {
+                    // what the workers' finish() would have waited for
+                    for (int c=1; c <= pool_conns; c++){
+                        try {
+                            getLastError(c);
+                        }
+                        catch (DBException&) {
+                            reconnectIfFailed(c);
+                        }
+                    }
+                }
+                endTime = boost::posix_time::microsec_clock::universal_time();
+                test->teardown();
+                if (tracer.sample)
+                    tracer.writeRound(test->name(), nthreads);
+                double micros = (endTime-startTime).total_microseconds() / 1000001.0;
+
+                BSONObjBuilder b;
+                b.append("time", micros);
+                b.append("ops", iterations);
+                b.append("ops_per_sec", iterations / micros);
+                if (bytes) {
+                    b.append("bytes", bytes);
+                    b.append("mb_per_sec", bytes / micros / (1024 * 1024));
+                }
+                latencies.appendTo(b);
+                failures.appendTo(b, iterations);
+                appendFairness(b, nthreads);
+                if (netem.enabled)
+                    netem.appendTo(b);
+                if (pool_conns) {
+                    // latencies above start once a connection is in hand
+                    BSONObjBuilder p;
+                    p.append("conns", pool_conns);
+                    p.append("workers_per_conn", double(nthreads) / pool_conns);
+                    BSONObjBuilder wait;
+                    poolWaits.appendTo(wait);
+                    p.append("wait", wait.obj());
+                    b.append("pool", p.obj());
+                }
+                b.append("harness_overhead_ns", harness_overhead_ns);
+                // the plan the optimizer picks with the data as the round left it
+                string ns;
+                Query q;
+                if (test->explainQuery(ns, q)) {
+                    try {
+                        b.append("plan", explain(ns, q));
+                    }
+                    catch (DBException& e) {
+                        reconnectIfFailed(_side[current_target]);
+                        b.append("plan_error", e.what());
+                    }
+                }
+                test->report(b);
+                if (phases.samples) {
+                    BSONObjBuilder p;
+                    phases.appendTo(p);
+                    b.append("phases", p.obj());
+                }
+                return b.obj();
+            }
+
+            // Doubles the thread count from 1 until throughput stops growing
+            // and p99 has crossed the SLO, then bisects around both the
+            // throughput peak and the SLO crossing.
+            void adaptiveSweep(TestBase* test, map<int, BSONObj>& rounds, BSONObjBuilder& knee) {
+                const int limit = max_threads - 1;
+                const double plateau = 1.05; // less than 5% better counts as flat
+
+                int best = 1;
+                int n = 1;
+                while (n < limit) {
+                    n = min(n * 2, limit);
+                    rounds[n] = runRound(test, n);
+
+                    bool improved = opsPerSec(rounds, n) > opsPerSec(rounds, best) * plateau;
+                    if (opsPerSec(rounds, n) > opsPerSec(rounds, best))
+                        best = n;
+                    if (!improved && firstOverSlo(rounds) != -1)
+                        break;
+                }
+
+                // refine the peak: probe the midpoint of the wider gap next to
+                // the best count until the neighbours are within ~10%
+                while (true) {
+                    map<int, BSONObj>::iterator it = rounds.find(best), prev = it, next = it;
+                    int lo = (it == rounds.begin()) ? best : (--prev)->first;
+                    int hi = (++next == rounds.end()) ? best : next->first;
+
+                    int probe;
+                    if (hi - best >= best - lo)
+                        probe = best + (hi - best) / 2;
+                    else
+                        probe = lo + (best - lo) / 2;
+                    if (probe == best || probe == lo || probe == hi || max(hi - best, best - lo) <= max(1, best / 10))
+                        break;
+
+                    rounds[probe] = runRound(test, probe);
+                    if (opsPerSec(rounds, probe) > opsPerSec(rounds, best))
+                        best = probe;
+                }
+
+                // refine the SLO crossing between the last passing and first failing count
+                int bad = firstOverSlo(rounds);
+                while (bad > 1) {
+                    int ok = 1;
+                    for (map<int, BSONObj>::iterator r=rounds.begin(); r->first < bad; ++r)
+                        ok = r->first;
+                    if (bad - ok <= max(1, ok / 10))
+                        break;
+                    int probe = ok + (bad - ok) / 2;
+                    rounds[probe] = runRound(test, probe);
+                    bad = firstOverSlo(rounds);
+                }
+
+                knee.append("peak_threads", best);
+                knee.append("peak_ops_per_sec", opsPerSec(rounds, best));
+                knee.append("slo_p99_micros", slo_p99_micros);
+                if (bad == -1) {
+                    knee.appendNull("slo_threads");
+                }
+                else {
+                    int ok = 0;
+                    for (map<int, BSONObj>::iterator r=rounds.begin(); r->first < bad; ++r)
+                        ok = r->first;
+                    knee.append("slo_threads", ok); // most threads that still met the SLO
+                    knee.append("slo_crossed_threads", bad);
+                }
+            }
+
+            static double opsPerSec(map<int, BSONObj>& rounds, int nthreads) {
+                return rounds[nthreads]["ops_per_sec"].number();
+            }
+
+            static int firstOverSlo(map<int, BSONObj>& rounds) {
+                for (map<int, BSONObj>::iterator r=rounds.begin(); r != rounds.end(); ++r){
+                    if (r->second["p99_micros"].numberLong() > slo_p99_micros)
+                        return r->first;
+                }
+                return -1;
+            }
+
+            void launch_subthreads(int threadId, TestBase* test, int seconds) {
+                if (!threadId) return;
+
+                boost::thread athread(boost::bind(&TestBase::run, test, threadId, seconds));
+
+                launch_subthreads(threadId - 1, test, seconds);
+
+                athread.join();
+            }
+    };
+
+/*
+    void clearDB(){
+        for (int i=0; i<max_threads; i++) {
+            _conn[0].dropDatabase(_db + BSONObjBuilder::numStr(i));
+            _conn[0].getLastError();
+            if (!multi_db)
+                return;
         }
+    }
+    */
+}
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
+/*
+namespace Insert{
+    struct Base{
+        void reset(){ clearDB(); }
+    };
+
+    struct Empty : Base{
+        void run(int t, int n) {
             for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("x" << base + i << "y" << ((base+i)%13)));
+                insert(t, BSONObj());
             }
         }
     };
 
-    struct TwoIntsSecondGood{
-        void reset() {
-            clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            ensureIndex(-1, BSON("y" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << (i%13) << "y" << i));
+    template <int BatchSize>
+    struct EmptyBatched : Base{
+        void run(int t, int n) {
+            for (int i=0; i < seconds / BatchSize / n; i++){
+                vector<BSONObj> objs(BatchSize);
+                insert(t, objs);
             }
-            getLastError();
         }
+    };
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
+    struct EmptyCapped : Base{
+        void run(int t, int n) {
             for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("x" << ((base+i)%13) << "y" << base+i));
+                insert(t, BSONObj());
             }
         }
-    };
-    struct TwoIntsBothBad{
-        void reset() {
+        void reset(){
             clearDB();
-            ensureIndex(-1, BSON("x" << 1));
-            ensureIndex(-1, BSON("y" << 1));
-            for (int i=0; i < seconds; i++){
-                insert(-1, BSON("x" << (i%503) << "y" << (i%509))); // both are prime
+            for (int t=0; t<max_threads; t++){
+                _conn[t].createCollection(ns[t], 32 * 1024, true);
+                if (!multi_db)
+                    return;
             }
-            getLastError();
         }
+    };
 
-        void run(int t, int n){
-            int base = t * (seconds/n);
+    struct JustID : Base{
+        void run(int t, int n) {
             for (int i=0; i < seconds / n; i++){
-                findOne(t, BSON("x" << ((base+i)%503) << "y" << ((base+i)%509)));
+                BSONObjBuilder b;
+                b << GENOID;
+                insert(t, b.obj());
             }
         }
     };
 
-}
-*/
+    struct IntID : Base{
+        void run(int t, int n) {
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                insert(t, BSON("_id" << base + i));
+            }
+        }
+    };
 
-static int userids[] = {
-  19455489, 5381772, 5701820, 5754058, 10876381, 5279698, 6130363, 6150116, 19368260, 19457933, 19457344,
-  19461626, 19460087, 19468439, 19471498, 19480617, 19488894, 19534335, 19542684, 19584682, 19642128, 1865666,
-  1851367, 5996532, 5139385, 5156629, 5180497, 5193466, 5313793, 5368017, 5374069, 5777830, 5517409, 5543195,
-  5631987, 5749877, 5875052, 5960534, 6014078, 6032225, 6033697, 6042999, 6054869, 6056953, 6061721, 6152341,
-  10930518, 10815503, 5305542, 5656610, 6097200, 19262825, 19430530, 19460833, 19484165, 19486131, 19486216,
-  19470329, 19473434, 19477845, 19484340, 19468227, 19491082, 19465018, 19475210, 19480370, 19484887, 19481308,
-  19524071, 19525107, 19523044, 19549779, 19566789, 19571543, 19591001, 19565545, 19622313, 19623234, 19607744,
-  19636836, 1862285, 703394, 762510, 761230, 5964600, 5272819, 5451372, 5993616, 5553594, 5743879, 5930071,
-  6078142, 5626619, 5262911, 5080634, 5109133, 5145545, 5175549, 5183400, 5202099, 5223949, 5293845, 5310342,
-  5313953, 5314923, 5346842, 5365646, 5382992, 5412741, 5414067, 5460185, 5466015, 5507624, 5552910, 5556613,
-  5566570, 5581125, 5611254, 5616810, 5627512, 5659487, 5665995, 5687388, 5698060, 5705066, 5716321, 5738754,
-  5747974, 5773013, 5782029, 5783917, 5809119, 5809598, 5830369, 5841450, 5850175, 5855878, 5867289, 5873944,
-  5875127, 5882234, 5912046, 5928831, 5949513, 5967876, 5973757, 5977662, 6011335, 6016486, 6037350, 6048204,
-  6090022, 6109023, 6152350, 10842433, 10894876, 5131479, 5589640, 5801160, 5947009, 6151093, 10812700, 10847949,
-  10848106, 10875217, 14209473, 6016112, 5297228, 5168087, 5205598, 5483321, 5252743, 5659936, 5697111, 5964392,
-  6126729, 6129525, 6147259, 6150967, 19279125, 19316933, 19408461, 19456273, 19430614, 19457846, 19461055,
-  19460472, 19459783, 19459820, 19460960, 19472964, 19489794, 19471851, 19476728, 19486590, 19483711, 19483504,
-  19480996, 19490337, 19486815, 19486720, 19490134, 19490824, 19465071, 19486503, 19486787, 19483645, 19489801,
-  19475499, 19467145, 19465930, 19463588, 19463753, 19470702, 19470827, 19467670, 19476429, 19474585, 19480254,
-  19479397, 19478401, 19477745, 19483573, 19482084, 19482118, 19481681, 19481342, 19487175, 19492168, 19491262,
-  19489820, 19489266, 19524500, 19522675, 19498000, 19494315, 19513811, 19517599, 19506799, 19504166, 19556622,
-  19550440, 19539017, 19555176, 19554888, 19557716, 19531969, 19561003, 19586202, 19590474, 19564687, 19570542,
-  19565195, 19587240, 19582965, 19591341, 19581870, 19600906, 19599117, 19605308, 19618747, 19622193, 19593570,
-  19622209, 19607217, 19623350, 19622821, 19625311, 19598992, 19653377, 19626978, 19632192, 19639692, 19649172,
-  19640637, 19631821, 19632736, 19632260, 19651459, 19649540, 19655146, 19654927, 19652514, 19629888, 12658,
-  1859137, 1866772, 1867627, 1850421, 2195431, 2196642, 19595500, 698977, 694913, 696531, 707688, 699189, 699224,
-  748804, 766384, 754784, 765009, 779270, 778280, 6128178, 14199358, 5424025, 5500389, 5345470, 6136177, 6072626,
-  5374094, 5348327, 5821083, 5829650, 5797758, 5770501, 5387479, 10847616, 6025659, 10869646, 5792764, 5331224,
-  5797735, 10845767, 5159803, 5861312, 6103909, 5708422, 5291410, 5075820, 10870196, 5378241, 6075888, 6051796,
-  5860247, 5261310, 5762915, 5845890, 5531363, 5981447, 5157842, 5758956, 5846161, 5077832, 5079905, 5080189,
-  5091536, 5092691, 5099202, 5101167, 5119235, 5145209, 5152923, 5158316, 5159709, 5160853, 5161458, 5171809,
-  5172973, 5176275, 5184879, 5194030, 5199809, 5201479, 5202181, 5203406, 5209544, 5215952, 5216860, 5217643,
-  5227613, 5230150, 5231773, 5233890, 5244923, 5246361, 5260515, 5263298, 5269271, 5273219, 5276604, 5280951,
-  5281704, 5283805, 5286734, 5291790, 5293197, 5294738, 5304232, 5307462, 5316174, 5319682, 5325920, 5339657,
-  5340013, 5340067, 5347366, 5355592, 5356845, 5359302, 5359982, 5360235, 5360326, 5360922, 5361339, 5367215,
-  5368315, 5371742, 5376226, 5377020, 5383694, 5383890, 5384829, 5390736, 5394298, 5395190, 5395193, 5397611,
-  5410450, 5410628, 5411635, 5581130, 5571493, 5474582, 6036667, 5711331, 5464844, 6110302, 5693510, 5417294,
-  5418586, 5418923, 5424500, 5425088, 5427567, 5433777, 5439533, 5440047, 5440870, 5447028, 5455880, 5458959,
-  5463818, 5464380, 5468671, 5468868, 5469239, 5473695, 5475999, 5478022, 5489925, 5497698, 5500647, 5500791,
-  5502899, 5502981, 5503109, 5506956, 5515654, 5525436, 5526007, 5527024, 5528163, 5528389, 5542513, 5547452,
-  5549007, 5551816, 5567258, 5572753, 5576758, 5580048, 5580553, 5583182, 5584008, 5585161, 5587541, 5588780,
-  5588982, 5592457, 5598318, 5603369, 5605317, 5607160, 5615687, 5616842, 5617707, 5620679, 5622710, 5622867,
-  5625267, 5628717, 5849973, 5634856, 5634955, 5638090, 5638270, 5638638, 5641407, 5641734, 5650178, 5650592,
-  5650601, 5661448, 5673059, 5674431, 5676038, 5680060, 5683914, 5689146, 5689561, 5695223, 5698031, 5700595,
-  5703525, 5705728, 5710803, 5714034, 5714108, 5719732, 5722924, 5732598, 5758643, 5761240, 5766655, 5774088,
-  5777134, 5779938, 5781723, 5783896, 5795937, 5796155, 5807080, 5808053, 5808930, 5817158, 5828844, 5829696,
-  5833765, 5835921, 5838918, 5843668, 5844483, 5848407, 5852020, 5858103, 5863974, 5866029, 5870436, 5875148,
-  5876798, 5882319, 5883883, 5884517, 5894257, 5897300, 5898649, 5911280, 5912611, 5914672, 5923499, 5924194,
-  5925854, 5929074, 5940136, 5947160, 5950297, 5951659, 5952243, 5958883, 5960304, 5965195, 5979799, 5980142,
-  5985731, 5987986, 5999497, 6002814, 6004400, 6006597, 6011030, 6011338, 6013784, 6030010, 6030791, 6033472,
-  6034955, 6036011, 6036254, 6039172, 6042677, 6043349, 6057708, 6064538, 6065159, 6066415, 6066801, 6068909,
-  6070412, 6070635, 6072739, 6076617, 6077155, 6077408, 6081856, 6094657, 6096344, 6098361, 6099843, 6099900,
-  6103653, 6112307, 6113048, 6114125, 6118547, 6123382, 6125191, 6127991, 6128159, 6128656, 6135000, 6137700,
-  6139012, 6142637, 6144525, 6145028, 6148856, 6149251, 6153492, 6166604, 6167666, 6168511, 10804260, 10809332,
-  10832518, 10833749, 10839485, 10847163, 10851553, 10893643, 10905933, 10913838, 10920605, 10936869, 5103172,
-  5263612, 5567663, 5596004, 5676569, 5707404, 5743537, 5800600, 5919465, 5952010, 5953799, 5955218, 5971574,
-  5986624, 6023933, 6042610, 6050102, 6051747, 6068192, 6078700, 6101250, 6149191, 6158449, 6170677, 5760618,
-  10807709, 10810905, 10818194, 10821574, 10823756, 10829484, 10832388, 10839435, 10853185, 10861244, 10866240,
-  10866370, 10866653, 10872761, 10877002, 10888104, 10890525, 10890886, 10891570, 10893415, 10897313, 10908865,
-  10918918, 10928832, 10930187, 10940366, 14208707, 5250473, 10807662, 10891818, 5324310, 5348322, 5409482,
-  5229785, 5814678, 10814491, 10819154, 10826159, 10849131, 10840525, 10837297, 10829038, 10878515, 10895638,
-  10893234, 10897418, 10910623, 10925127, 5473378, 5087930, 5093806, 5104117, 5137322, 5147662, 5152343, 5186475,
-  5196533, 5206699, 5221130, 5249253, 5270882, 5276681, 5308780, 5323710, 5326066, 5338018, 5337515, 5386754,
-  5428515, 5427860, 5436370, 5442775, 5471932, 5479092, 5484866, 5510605, 5525956, 5531050, 5560484, 5573746,
-  5581493, 5585552, 5605648, 5637731, 5638045, 5650510, 5660604, 5683519, 5692462, 5703468, 5730609, 5781849,
-  5781202, 5793186, 5817511, 5849077, 5877373, 5914305, 5920081, 5957880, 5957314, 5972804, 5979165, 5984197,
-  5994281, 6012157, 6036466, 6041440, 6075155, 6124029, 6141693, 6167230, 14226276, 15369087, 19245618, 19256981,
-  19255374, 19237120, 19256384, 19246328, 19240321, 19245401, 19227382, 19231241, 19231493, 19236009, 19235992,
-  19233082, 19233430, 19246627, 19255462, 19269216, 19288270, 19273862, 19259296, 19282374, 19278981, 19326603,
-  19322115, 19297717, 19300129, 19311961, 19315198, 19323960, 19363287, 19360840, 19376819, 19380535, 19389149,
-  19389213, 19370457, 19397636, 19418406, 19424611, 19425820, 19443798, 19450976, 19455250, 19454097, 19430166,
-  19436950, 19455116, 19437150, 19435917, 19433708, 19439617, 19439673, 19438059, 19446292, 19443533, 19442892,
-  19448243, 19447150, 19451264, 19458919, 19457822, 19456532, 19456066, 19456255, 19455888, 19462413, 19461979,
-  19460587, 19459700, 19451902, 19433627, 19435027, 19442564, 19447017, 19455143, 19430927, 19459719, 19441884,
-  19438798, 19448479, 19485623, 19490389, 19493688, 19491155, 19482054, 19482627, 19466365, 19492032, 19490298,
-  19479903, 19481758, 19467643, 19487017, 19481192, 19463348, 19467041, 19471363, 19470279, 19469930, 19468929,
-  19467534, 19476059, 19473459, 19472502, 19472339, 19480079, 19479657, 19477113, 19488943, 19487842, 19490566,
-  19489458, 19478569, 19473530, 19488787, 19493403, 19463129, 19473532, 19480711, 19484105, 19468882, 19471727,
-  19485033, 19489164, 19489645, 19483538, 19471110, 19471657, 19481891, 19481417, 19488316, 19481727, 19465226,
-  19476474, 19492777, 19493012, 19465585, 19466620, 19464919, 19465983, 19463089, 19479530, 19482735, 19483833,
-  19483030, 19481437, 19479541, 19484757, 19472875, 19470075, 19492814, 19486142, 19481725, 19464009, 19474161,
-  19466613, 19463391, 19462702, 19467376, 19466872, 19465582, 19465850, 19465155, 19464858, 19463897, 19471112,
-  19469741, 19469279, 19469467, 19468020, 19468022, 19475943, 19474502, 19474511, 19474718, 19473540, 19473059,
-  19473222, 19472715, 19472047, 19472187, 19472483, 19480045, 19480192, 19479211, 19479264, 19479362, 19477835,
-  19477866, 19484580, 19484882, 19484115, 19483928, 19482556, 19482912, 19482316, 19481881, 19481081, 19480788,
-  19480952, 19488555, 19488061, 19487531, 19487001, 19487154, 19486636, 19486995, 19486016, 19485677, 19491585,
-  19491831, 19491995, 19491387, 19491441, 19490650
-};
+    struct IntIDUpsert : Base{
+        void run(int t, int n) {
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                update(t, BSON("_id" << base + i), BSONObj(), true);
+            }
+        }
+    };
 
-OID venueids[] = {
-  OID("4e228599483b041af1f8994a"), OID("4e68e178ae60186280adbd11"), OID("4e482388183849317e8df0a8"),
-  OID("4c08d4167e3fc928c1e0f082"), OID("4c17fc751436a59323ab8c75"), OID("4e64c6aed164ddd5e6bfe8f1"),
-  OID("4c85976b77be76b04b41b776"), OID("4e10727822713f7d7bc81ca6"), OID("4b8c1444f964a5209abc32e3"),
-  OID("4bfe5e7fee20ef3b838a3c5e"), OID("4c18007f2cddb7137514831e"), OID("4c6eda32d97fa1438232f1ca"),
-  OID("4df40f7fae609e69dd9c111c"), OID("4e006ac17d8beaa1649c4ce8"), OID("4e3b3b1ab61cb577be5a06ec"),
-  OID("4c1cb4afb4e62d7f316ddb93"), OID("4b15507ef964a520aeb023e3"), OID("4bfa6d655317a5934196027f"),
-  OID("4b330432f964a5200d1725e3"), OID("4df90e321495b7db1b109908"), OID("4dc0172bf7b115b875d850f1"),
-  OID("4e3ff4037d8b0e9610894992"), OID("49e39fa6f964a520a2621fe3"), OID("4e252915ae6035bd16f32da1"),
-  OID("4be3c4fef07b0f47d4e4f843"), OID("4b744584f964a5208ad12de3"), OID("4bb627766edc76b01b7a301c"),
-  OID("4b53e7adf964a52060ae27e3"), OID("4b774467f964a5203c8d2ee3"), OID("4d48113353ebba7a41785bac"),
-  OID("4cbf6411ca4aa1cd66cd19b4"), OID("41253f00f964a5204b0c1fe3"), OID("4c73d4c93c26ef3be1d2e6d5"),
-  OID("4c1e4000eac020a1105e49c2"), OID("4a55c1f7f964a52046b41fe3"), OID("4b554f0ff964a5205ce127e3"),
-  OID("4c7ffb24e602b1f7fd8b857a"), OID("4bfe74f9bf6576b04eafaeb8"), OID("4e5b973c813034cf45e42a5f"),
-  OID("4b994c11f964a520057135e3"), OID("4cb48d14cbab236af126bf73"), OID("4d6cc24540fc8eec87f89eba"),
-  OID("4bc4aee4f8219c74cbb7b710"), OID("4d13aa9d2b1fa35dca8c4ab1"), OID("4e15eebad22d026fa772f42c"),
-  OID("4b12c9c5f964a5202f8e23e3"), OID("4b65e495f964a52097062be3"), OID("4c5727cb7329c9286d398e80"),
-  OID("4d163c98b15cb1f79ffdac21"), OID("4d4c3db22d0d8cfac470cd25"), OID("4d3ac39ecc48224b7f46404f"),
-  OID("4b01aa68f964a520664422e3"), OID("4de9fae01f6e3ddebdbf7d69"), OID("4c13e54c7f7f2d7f4cf1df68"),
-  OID("4c1913f24ff90f4788610f49"), OID("4d2c488c342d6dcb06b71dcb"), OID("4b058700f964a5208b7a22e3"),
-  OID("4e880121f5b9fed680cd87bd"), OID("4b6303a7f964a520b55d2ae3"), OID("4cf85031e8e254817bdfd662"),
-  OID("4c82749374d7b60cea4880d8"), OID("4dd381bd2271d21ebd3e0502"), OID("4b5672d5f964a520d11028e3"),
-  OID("4b0a8824f964a520dd2423e3"), OID("4baeae08f964a52020ce3be3"), OID("4e5eefc618a870f60f3386f7"),
-  OID("4c7c2aa720bb199c20292329"), OID("4b2b4ca4f964a520a2b524e3"), OID("4b5b47caf964a5200cf128e3"),
-  OID("4dea3248d164ef597ce39c03"), OID("4a406f30f964a52098a41fe3"), OID("4bcfd6d741b9ef3b9341f9e5"),
-  OID("3fd66200f964a520bbe61ee3"), OID("4c5005931886c9b6dce0fa27"), OID("4deaae1f88774880e323a487"),
-  OID("4e8db778d3e3720da3fbdb79"), OID("4ba5027af964a520eccf38e3"), OID("4b8827b5f964a52093e331e3"),
-  OID("4b44dbfcf964a52078fe25e3"), OID("4b9d90d4f964a520feb336e3"), OID("4c129682a5eb76b0ec74beb7"),
-  OID("4ce1c61c00166ea8223a4388"), OID("4c893b24ed0aa1439c0bb0f3"), OID("4e7f366a9a52594cdf7897ec"),
-  OID("4e7c497b45ddcbc91eac15a7"), OID("4be79e6de1b39521b41e21c1"), OID("4d46f1f01911a0932391f0d8"),
-  OID("4e56be3d18a81fe3e5f1aeb9"), OID("4e252a23d22df6f888772101"), OID("4cc0b364083a9c74fba73678"),
-  OID("4c24996ec11dc9b6cfa52524"), OID("4d8d930c3bfef04de3638486"), OID("4b3d7bcaf964a520c69425e3"),
-  OID("4b62e276f964a52040572ae3"), OID("4c0f0c667189c9283699d9b6"), OID("4b0588dff964a520d8dd22e3"),
-  OID("4b995fd0f964a520ae7635e3"), OID("4b4be91ef964a52010ab26e3"), OID("4d9e033da1ec8cfa95f3114a"),
-  OID("4c36129e3849c9289666bbb1"), OID("4c24deeb905a0f4750796060"), OID("4813c340f964a5204b4f1fe3"),
-  OID("4b4e7160f964a520eeed26e3"), OID("40b13b00f964a520a2f61ee3"), OID("4b6988f1f964a5204fa62be3"),
-  OID("4b7a2519f964a52078242fe3"), OID("4b19839ef964a520acde23e3"), OID("4c98e850671db60c5871bdf6"),
-  OID("4ddac24ed22d4dbc8c0bbd22"), OID("4dac2dfd5da3ba8a47b012db"), OID("4a8d54eef964a520760f20e3"),
-  OID("4b4b489df964a520709626e3"), OID("4c1b892e624b9c74ba9f1204"), OID("4da88c9381541df437bfd00b"),
-  OID("4b64bc16f964a52009cc2ae3"), OID("4cd4cb1c2944b1f7bf7059ec"), OID("4c4dabe251c2c9280016309d"),
-  OID("4d92b679b053b60c78857fcb"), OID("439530e7f964a520882b1fe3"), OID("4a997418f964a520672e20e3"),
-  OID("4dea287445dd3993a8833862"), OID("4aabf233f964a520195b20e3"), OID("4ba6b36df964a520f46939e3"),
-  OID("4caded9a2303a143347feaf0"), OID("4aebfa97f964a5202dc521e3"), OID("4e179c7752b123a586cef176"),
-  OID("4b5bebc0f964a5205a1d29e3"), OID("4d31c68f2e56236ab0ef15b4"), OID("4cbb5725dd41a35d889feda0"),
-  OID("4c2e63817cc0c9b6a2f7e99a"), OID("4b0a71d7f964a5201a2423e3"), OID("4b6b9d16f964a52094122ce3"),
-  OID("4c4b2b88712ac9288ad8896c"), OID("4c378df43849c92828ebbdb1"), OID("4e0cfc16d22d8582bdb11dd3"),
-  OID("4a970136f964a520eb2720e3"), OID("4c1be865b4e62d7fdf2eda93"), OID("4a71a12af964a5204ed91fe3"),
-  OID("4dcf0b14d4c065592f8f33a9"), OID("4e09fbb518a8382643c5f30c"), OID("4af5edc6f964a520f0fe21e3"),
-  OID("4c3c8fcd933b0f479235e421"), OID("4e4276971f6ec93e92549055"), OID("4b8fff9df964a520166f33e3"),
-  OID("4c34c4147cc0c9b63ee5f39a"), OID("4b093cd0f964a520db1423e3"), OID("4b4a420df964a520268126e3"),
-  OID("4c1be590b306c928fcf862b7"), OID("4b08baf5f964a520861123e3"), OID("4c3cff2817f2ef3bd94281f4"),
-  OID("4df4ff9081dc20cdb9af891e"), OID("4ade60ecf964a520747521e3"), OID("4e7e875d77c8c4fb96c4e32a"),
-  OID("4e8475b7c2ee9c188c1579a2"), OID("4c3613f6298e9c7497a507e3"), OID("4c14ad9077cea5935ffed060"),
-  OID("4bc2829eabf4952159b4c293"), OID("4bed35e29868a593f2045d46"), OID("4c74420966be6dcbb739bd0f"),
-  OID("4d99938ac19fb60cee8ec665"), OID("4adcdebcf964a5201b6221e3"), OID("49b15db9f964a520d5521fe3"),
-  OID("49e4b762f964a5201e631fe3"), OID("4baea9fff964a52067cc3be3"), OID("4e7ff9e4b80383b0e008c618"),
-  OID("4d112ed05f3376eb368a1386"), OID("4d07873b9d33a143e367cc78"), OID("4abf8dd7f964a520139120e3"),
-  OID("4ada3a78f964a520422021e3"), OID("4b6cb20cf964a520ea4c2ce3"), OID("4b9222d1f964a520dae833e3"),
-  OID("4bf944e2bb5176b0328c5bb2"), OID("4c488c0131e41b8dd4745035"), OID("4c0123e819d8c928a5508829"),
-  OID("4b439f6af964a5208fe425e3"), OID("4bd5021e6f64952164916eec"), OID("4b094ad8f964a520501523e3"),
-  OID("4e2c957052b1b8f1986da3ef"), OID("4b3bb4b3f964a520467925e3"), OID("4e39205eaeb72d065964b8af"),
-  OID("4b4258cff964a52016d225e3"), OID("4d70d062b48c236a417fd357"), OID("4dab13ec6a2303012f1b84ac"),
-  OID("4b60bb01f964a52047f629e3"), OID("4d7ba7dd7498a1cd892f6efc"), OID("4bb78e4eb35776b072c4c701"),
-  OID("4bf5d4245e800f47ba57e6d4"), OID("4b92cd1cf964a520171d34e3"), OID("4d835fa799b78cfab3d59e1f"),
-  OID("4e77be77fa769112d4fe6465"), OID("4ac3f607f964a520a79d20e3"), OID("4b16ad7ef964a520e4bb23e3"),
-  OID("4d9b2ec403d8721e96a3e124"), OID("4b82e25ef964a520e8ea30e3"), OID("4dfcdb54b61c84188eee403d"),
-  OID("4c9d1641d3c2b60cebd4bdbc"), OID("4cd44e0ea5b346885f2b8750"), OID("4ddace5c2271ac9047657a5f"),
-  OID("4b870349f964a52067ab31e3"), OID("4b312e7df964a520fc0125e3"), OID("4e8644f19adf376009a61900"),
-  OID("4c9356a5f600236ade70c432"), OID("4aedc915f964a520e2ce21e3"), OID("4b3bcdf1f964a520827b25e3"),
-  OID("4d150f8a8312236a8e824fba"), OID("4dc17e4e1838710f437ed107"), OID("4bd8d3132e6f0f47eccc0808"),
-  OID("4bd4c5226f649521a3196eec"), OID("4e58abea2271886714e89aad"), OID("4b9ab395f964a5206cce35e3"),
-  OID("4b65c9adf964a520bfff2ae3"), OID("4e57ded418a82d0a334c1eba"), OID("4a663032f964a5202fc81fe3"),
-  OID("4e826a4e77c85da056dd387b"), OID("4cd571fa122ba143e60b2ca1"), OID("4d658cdb6d943704cfaf78bf"),
-  OID("4540820cf964a5203c3c1fe3"), OID("4cb13eaff2dbef3b36dd79e5"), OID("4a3ecf0cf964a52075a31fe3"),
-  OID("4c55203afd2ea5937fdb312b"), OID("4ba3e7e1f964a520486c38e3"), OID("4c60fc9a1e5cd13a6a0ea3ed"),
-  OID("4b00400cf964a520f93b22e3"), OID("4be5bd27910020a15369d314"), OID("4bb7c509b35776b0ae26c801"),
-  OID("43c51016f964a520632d1fe3"), OID("4cb127fb39458cfa096909a0"), OID("4d4e7e034a38b60c0a7dea66"),
-  OID("4c8523bdd8086dcbe4fa8e52"), OID("4c88104f10523704098fbdf1"), OID("4bdfd3eb0ee3a593857a35b0"),
-  OID("4bff5fdfe584c9285e296e25"), OID("4b9c6605f964a520bb6536e3"), OID("4b58239df964a520f74b28e3"),
-  OID("4bb709be46d4a5938e0dc7c0"), OID("4c00e476ad15a59342938e73"), OID("4b671d69f964a520a13b2be3"),
-  OID("4bf08bf117880f47a3782937"), OID("4c9386d6533aa093669fb645"), OID("4b13f559f964a520f19a23e3"),
-  OID("4b9e5440f964a52064da36e3"), OID("4d9b551a7709cbff0c7e3ab2"), OID("4e53ff5a1495a46b65be98db"),
-  OID("481354f5f964a5203a4f1fe3"), OID("4c295c3be19720a1887af958"), OID("4d36f5e7d8caa1cd2b4d72d6"),
-  OID("4c9846df671db60cd144b8f6"), OID("4a43bcb7f964a520bba61fe3"), OID("4c6d73dde6b7b1f7cdc6a98e"),
-  OID("4dc30fe1ae608779d0ff7bda"), OID("4b6061cbf964a520dbe229e3"), OID("4c35ded5a0ced13a5a6d1a6e"),
-  OID("4ad4c00ef964a520f2ed20e3"), OID("4e2c0cb4b61cd010837b440d"), OID("4be533b8d4f7c9b6ee272520"),
-  OID("4be46c7c910020a1e0b1d114"), OID("4bf82e038d30d13a3d4b0018"), OID("4b87952cf964a52071c331e3"),
-  OID("4ec16d1cbe7b04923d264c7c"), OID("4b05b4c1f964a52047e122e3"), OID("4c8b9b752e3337042167ce41"),
-  OID("4b1a85c5f964a52097eb23e3"), OID("4b199d10f964a5207ee023e3"), OID("4bac6730f964a52095f33ae3"),
-  OID("4b166e4ef964a520fdb823e3"), OID("4af2dc2af964a520d0e821e3"), OID("4d08bd38611ff04dd77b1cfb"),
-  OID("4b6335bff964a520d16a2ae3"), OID("4ba55045f964a5208ff938e3"), OID("43a3c20df964a5203f2c1fe3"),
-  OID("4b8d6ad3f964a5206afa32e3"), OID("446d8fa5f964a52067331fe3"), OID("4b61c1fff964a520e1202ae3"),
-  OID("4c34f5823ffc95212e0a91f5"), OID("4b537a46f964a520f29e27e3"), OID("4d9e3cf714013704d7ad12b6"),
-  OID("4bb4402e87aa95216b0badd1"), OID("4b53f7ccf964a520baaf27e3"), OID("4b7b07b0f964a5204a4d2fe3"),
-  OID("4ae8be15f964a520e0b121e3"), OID("4cfab116c51fa1cdbd55e22b"), OID("4b4b1876f964a520389226e3"),
-  OID("4b529ebdf964a520218427e3"), OID("4b94a7aff964a520c07f34e3"), OID("4ba23ad0f964a5205de537e3"),
-  OID("4ba2e967f964a520162238e3"), OID("4412be02f964a520d6301fe3"), OID("4adcdb01f964a520ad5e21e3"),
-  OID("4c1dc0d0b4e62d7f3c55dd93"), OID("4adcdaa0f964a520a04d21e3"), OID("4b0b549ff964a520773023e3"),
-  OID("4addf02df964a5207d6621e3"), OID("4d733b64ff6ba35d59417a8a"), OID("4b2d0e1af964a52037cd24e3"),
-  OID("4b99bfc5f964a520e58f35e3"), OID("4c8cf4db5e048cfa0334d1cd"), OID("4ada5ad8f964a520bf2121e3"),
-  OID("49ca8f4df964a520b9581fe3"), OID("4b97ce38f964a520bb1635e3"), OID("4c572a546201e21e394a556e"),
-  OID("4ba3e14ff964a520936938e3"), OID("4bd9d9395f34b713a8df3579"), OID("4d3f8de546775481fc0050f4"),
-  OID("4ca8d8ef44a8224bdfc81b40"), OID("4d432f28f354236a8476796d"), OID("4d41462d00e8a35dca8802fb"),
-  OID("4e7251701f6ecfe82c35d18d"), OID("4dfcf57dd164848a03f780f3"), OID("4e2ce14ad22d3f83c89e8f5f"),
-  OID("4c5ecbba7f661b8d8af24e1c"), OID("4be497ce910020a15df1d114"), OID("4e30422f62e1fbac61137f70"),
-  OID("4c09aeb4ffb8c9b6786e6a61"), OID("4c09fd76009a0f476ac2e8bf"), OID("4e5139ecc65bb313ba9ea493"),
-  OID("4bb5b72e46d4a593a145c5c0"), OID("4e7f61d661af411b6306a7d5"), OID("4e604d9c2271573ad6ae7229"),
-  OID("4b525f22f964a520ea7927e3"), OID("4bfb45fdd0382d7fa188c90a"), OID("4b2c9a88f964a52014c824e3"),
-  OID("4e67b9cfae609d64bd03e867"), OID("4a0768b0f964a5205c731fe3"), OID("4b50f751f964a520f53a27e3"),
-  OID("4e7660f4cc3fc1186ed4599f"), OID("4d46cac61ed56dcbba6fc954"), OID("4b28eef1f964a520499624e3"),
-  OID("4e8a58d8be7b5e7d9602bcde"), OID("4e698e55a809290267a15df3"), OID("4c2e4501e307d13a65470fda"),
-  OID("4e99d3d6be7bc875aa3ebb7a"), OID("4d30af6982fd5481bca5b5a8"), OID("4bf1d84a99d02d7f7ea3c948"),
-  OID("4c336c206f1fef3b208aec3d"), OID("49c43671f964a520ae561fe3"), OID("4c617d2554ac0f47e10bb821"),
-  OID("4cd494a1122ba1434d6a26a1"), OID("45f412e6f964a520f6431fe3"), OID("4b6158ebf964a520af102ae3"),
-  OID("4c66b5e0b80abe9a96a8cde5"), OID("4bd5eca66f649521ccf66fec"), OID("4e246d9ad22d0a3f5a1571bf"),
-  OID("4c5aef82ec2520a104b75212"), OID("4d8b1ecd6ce6a35df7156e42"), OID("4e636dfbe4cdf1e2bfb7221d"),
-  OID("4cc952babcb1b1f7f8470e8a"), OID("4df75fa2aeb7da11e1a8a74e"), OID("4ce93b078ef78cfa37909f9b"),
-  OID("4d0610b992288eec008c9ce0"), OID("4e7bafdbae60ed9a4aafaa2b"), OID("4b4f0af6f964a52023f926e3"),
-  OID("4bad56adf964a520b5473be3"), OID("4dfa656c18a8ab1870be07a0"), OID("4e814d8d6da173f429b24d1c"),
-  OID("4bdb1dde63c5c9b6256b2668"), OID("4c9349bc911b8cfa2043f4b5"), OID("4bd054c677b29c74e07e8a82"),
-  OID("4c67b3a67abde21e59426768"), OID("4bdadc2063c5c9b6d1362568"), OID("4b8bc3aff964a5203caa32e3"),
-  OID("4ca35d3b7f84224b9e28c458"), OID("4bbe7a3782a2ef3b017d2bd2"), OID("4c2d6bc97d85a59399b252f3"),
-  OID("4b652435f964a52009e62ae3"), OID("4e899083be7b57d7d6e9eec2"), OID("4c7428dadb52b1f7574875dc"),
-  OID("4b677150f964a520394f2be3"), OID("4a36f332f964a5200c9e1fe3"), OID("4c38e2530a71c9b6508941c9"),
-  OID("4b6741a3f964a52034442be3"), OID("4e97aebe6c25f5286029d5cd"), OID("4c5ada266407d13a9b99b528"),
-  OID("4e02b3ebae6099b226e0a8ca"), OID("4df701ad483b96f73159134c"), OID("4e2abce352b1b8f1985935f1"),
-  OID("4dca4a9a183817362fdf2570"), OID("4b6159ccf964a520c7102ae3"), OID("4d678fb12433a143d40c4de0"),
-  OID("4a7dc82ef964a52098ef1fe3"), OID("4d0943ab9232236a6440c253"), OID("4c2b548b77cfe21e5247b4f1"),
-  OID("4c1e915ab306c928be4467b7"), OID("4b621f1df964a520d9362ae3"), OID("4b7b6d7af964a5201d632fe3"),
-  OID("4b565ebef964a5208c0d28e3"), OID("43c922c9f964a520972d1fe3"), OID("4dd557fe8877e2b7c5eeaecb"),
-  OID("4bd7225529eb9c74f94396e1"), OID("4bddd6cbe75c0f4765d0c503"), OID("4b269ac4f964a520367e24e3"),
-  OID("4a5ff47ff964a52090c01fe3"), OID("4b996ef9f964a5202d7b35e3"), OID("4bef2436f2712d7f9e5ffbd8"),
-  OID("4e5c0dc0b99329e22ae14682"), OID("413e4b80f964a520521c1fe3"), OID("4c3639101e06d13a96d9733e"),
-  OID("4cc36fbc91413704abfabb55"), OID("4e90950adab46521c1238498"), OID("4bcdb288fb84c9b67b60223e"),
-  OID("4bf343ed98ac0f4713c062a8"), OID("4ca2e52e5720b1f7d2302def"), OID("4dbd47e5a86e0e98a1f72d18"),
-  OID("4cd148ff6449a093041ccfcf"), OID("4d520d4ce02754819f0cb1b6"), OID("4cb3fed8c5e6a1cdd925f0f6"),
-  OID("4e689b8745dd6cc5bd0e2b0a"), OID("4cf3e2bb8333224b1d01188e"), OID("4b63406af964a520a36d2ae3"),
-  OID("4e930f1d8231bf0d17a4c2b7"), OID("4d2368ec2eb1f04d980008c2"), OID("4d07363830a58cfa783fafe7"),
-  OID("4b2ca711f964a52053c824e3"), OID("4e7aef0b6365723c65113a69"), OID("4d38747c3ffba143fcac5c56"),
-  OID("4b6dd554f964a52019942ce3"), OID("4e6617901838ad3d105c5f1f"), OID("4e298e4545ddfe8f9dfd264c"),
-  OID("4ea2087be3008f7d91ea8814"), OID("4b3110bef964a52073ff24e3"), OID("4bcf762a0ffdce72dc81b2c0"),
-  OID("4bb4564d49bdc9b64ab90c10"), OID("4b7f6ebff964a520552e30e3"), OID("4c79340abd346dcbd47ef4ef"),
-  OID("4c4b5aaf5609c9b615570391"), OID("4cc44d71d43ba143970266f8"), OID("4b99a2e8f964a520f38835e3"),
-  OID("4dfdf3cb7d8b30508019d0fa"), OID("4f4e9924e4b0f03ee60bb5dd"), OID("4f5b9ca0e4b0b28dd40cfa0c"),
-  OID("4acbc300f964a52058c520e3"), OID("4cb18feb39458cfab5670ca0"), OID("4b772338f964a5201d812ee3"),
-  OID("4c4535eb429a0f47a0e1491e"), OID("4b5d4c0cf964a5201f5929e3"), OID("4babbe56f964a52094c53ae3"),
-  OID("4c967d8438dd8cfa8cf9db62"), OID("4c1091a43ce120a1b452081c"), OID("4aa44e08f964a5204f4620e3"),
-  OID("4e8e4f94b8034831903baae9"), OID("4db588fd4df05e5aaaf43454"), OID("4bec61c2b68520a1ec081287"),
-  OID("4b5b1038f964a52094e128e3"), OID("4bb38b8f42959c74fb16222c"), OID("4bf328ca354e9c74c88d2602"),
-  OID("4e7a867ae4cdbba061cba356"), OID("446e0714f964a52075331fe3"), OID("4dea9aee7d8b6c7a53444996"),
-  OID("4b5270f4f964a520737d27e3"), OID("4c6e8f7ed5c3a1cd5591c82b"), OID("4b5ce66ef964a5200c4a29e3"),
-  OID("4e90179c2c5b7295bbb43f32"), OID("4bb41c28f187a593f1e913f8"), OID("4df8be7dae608a367cea8cbe"),
-  OID("4b45f75ef964a520141326e3"), OID("4e6fbc74aeb7e676a77de125"), OID("4e89ed78f790d7f88f3a1e68"),
-  OID("4bad1f39f964a520d52f3be3"), OID("4c6152ba54ac0f47519ab721"), OID("4b1168a6f964a520fb7b23e3"),
-  OID("4e92d0baa17cdc523bbf56d0"), OID("4c1b4deec09ed13a1a74828e"), OID("4e907bdc6c25abdcf4b6ba68"),
-  OID("47fd0d51f964a520da4e1fe3"), OID("4d9ab4a1674ca143e5a6c143"), OID("4b77064ff964a52088752ee3"),
-  OID("4b228c46f964a520cc4824e3"), OID("4d42404eb0c354812143def1"), OID("4c68980a773720a1831480e9"),
-  OID("4c51f13ab6dabe9a919e8b12"), OID("4c6009e523e303bb50d07407"), OID("4e427f7a18a8627fce4674c9"),
-  OID("4e987b3502d5a39437282663"), OID("4e3cbc41fa76455375af719e"), OID("4b3a1855f964a520026125e3"),
-  OID("4c8c4d0fc37a6dcba269f67a"), OID("4d100f5a71e8a1cd62977ebd"), OID("4e642825c65b2dc8a05fdbe3"),
-  OID("4dd72350d4c05d5096e31bb2"), OID("4d35ce8d98336dcb893545f0"), OID("4b5236eef964a5204d7027e3"),
+    struct JustNum : Base{
+        void run(int t, int n) {
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                insert(t, BSON("x" << base + i));
+            }
+        }
+    };
+
+    struct JustNumIndexedBefore : Base{
+        void run(int t, int n) {
+            ensureIndex(t, BSON("x" << 1));
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                insert(t, BSON("x" << base + i));
+            }
+        }
+    };
+
+    struct JustNumIndexedAfter : Base{
+        void run(int t, int n) {
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                insert(t, BSON("x" << base + i));
+            }
+            ensureIndex(t, BSON("x" << 1));
+        }
+    };
+
+    struct NumAndID : Base{
+        void run(int t, int n) {
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                BSONObjBuilder b;
+                b << GENOID;
+                b << "x" << base+i;
+                insert(t, b.obj());
+            }
+        }
+    };
+}
+
+namespace Update{
+    struct Base{
+        void reset(){ clearDB(); }
+    };
+
+    struct IncNoIndexUpsert : Base{
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)), 1);
+                }
+            }
+        }
+    };
+    struct IncWithIndexUpsert : Base{
+        void reset(){ clearDB(); ensureIndex(-1, BSON("count" << 1));}
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)), 1);
+                }
+            }
+        }
+    };
+    struct IncNoIndex : Base{
+        void reset(){
+            clearDB();
+            for (int i=0; i<100; i++)
+                insert(-1, BSON("_id" << i << "count" << 0));
+        }
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)));
+                }
+            }
+        }
+    };
+    struct IncWithIndex : Base{
+        void reset(){
+            clearDB();
+            ensureIndex(-1, BSON("count" << 1));
+            for (int i=0; i<100; i++)
+                insert(-1, BSON("_id" << i << "count" << 0));
+        }
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("_id" << i), BSON("$inc" << BSON("count" << 1)));
+                }
+            }
+        }
+    };
+    struct IncNoIndex_QueryOnSecondary : Base{
+        void reset(){
+            clearDB();
+            ensureIndex(-1, BSON("i" << 1));
+            for (int i=0; i<100; i++)
+                insert(-1, BSON("_id" << i << "i" << i << "count" << 0));
+        }
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("i" << i), BSON("$inc" << BSON("count" << 1)));
+                }
+            }
+        }
+    };
+    struct IncWithIndex_QueryOnSecondary : Base{
+        void reset(){
+            clearDB();
+            ensureIndex(-1, BSON("count" << 1));
+            ensureIndex(-1, BSON("i" << 1));
+            for (int i=0; i<100; i++)
+                insert(-1, BSON("_id" << i << "i" << i << "count" << 0));
+        }
+        void run(int t, int n) {
+            const int incs = seconds/n/100;
+            for (int i=0; i<100; i++){
+                for (int j=0; j<incs; j++){
+                    update(t, BSON("i" << i), BSON("$inc" << BSON("count" << 1)));
+                }
+            }
+        }
+    };
+}
+
+namespace Queries{
+    struct Empty{
+        void reset() {
+            clearDB();
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSONObj());
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int chunk = seconds / n;
+            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
+            cursor->itcount();
+        }
+    };
+
+    struct HundredTableScans{
+        void reset() {
+            clearDB();
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSONObj());
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            for (int i=0; i < 100/n; i++){
+                findOne(t, BSON("does_not_exist" << i));
+            }
+        }
+    };
+
+    struct IntID{
+        void reset() {
+            clearDB();
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("_id" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int chunk = seconds / n;
+            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
+            cursor->itcount();
+        }
+    };
+
+    struct IntIDRange{
+        void reset() {
+            clearDB();
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("_id" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int chunk = seconds / n;
+            auto_ptr<DBClientCursor> cursor = query(t, BSON("_id" << GTE << chunk*t << LT << chunk*(t+1)));
+            cursor->itcount();
+        }
+    };
+
+    struct IntIDFindOne{
+        void reset() {
+            clearDB();
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("_id" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("_id" << base + i));
+            }
+        }
+    };
+
+    struct IntNonID{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int chunk = seconds / n;
+            auto_ptr<DBClientCursor> cursor = query(t, BSONObj(), chunk, chunk*t);
+            cursor->itcount();
+        }
+    };
+
+    struct IntNonIDRange{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int chunk = seconds / n;
+            auto_ptr<DBClientCursor> cursor = query(t, BSON("x" << GTE << chunk*t << LT << chunk*(t+1)));
+            cursor->itcount();
+        }
+    };
+
+    struct IntNonIDFindOne{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("x" << base + i));
+            }
+        }
+    };
+
+    struct RegexPrefixFindOne{
+        RegexPrefixFindOne(){
+            for (int i=0; i<100; i++)
+                nums[i] = "^" + BSONObjBuilder::numStr(i+1);
+        }
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << BSONObjBuilder::numStr(i)));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            for (int i=0; i < seconds / n / 100; i++){
+                for (int j=0; j<100; j++){
+                    BSONObjBuilder b;
+                    b.appendRegex("x", nums[j]);
+                    findOne(t, b.obj());
+                }
+            }
+        }
+        string nums[100];
+    };
+
+    struct TwoIntsBothGood{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            ensureIndex(-1, BSON("y" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << i << "y" << (seconds-i)));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("x" << base + i << "y" << (seconds-(base+i))));
+            }
+        }
+    };
+
+    struct TwoIntsFirstGood{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            ensureIndex(-1, BSON("y" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << i << "y" << (i%13)));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("x" << base + i << "y" << ((base+i)%13)));
+            }
+        }
+    };
+
+    struct TwoIntsSecondGood{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            ensureIndex(-1, BSON("y" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << (i%13) << "y" << i));
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("x" << ((base+i)%13) << "y" << base+i));
+            }
+        }
+    };
+    struct TwoIntsBothBad{
+        void reset() {
+            clearDB();
+            ensureIndex(-1, BSON("x" << 1));
+            ensureIndex(-1, BSON("y" << 1));
+            for (int i=0; i < seconds; i++){
+                insert(-1, BSON("x" << (i%503) << "y" << (i%509))); // both are prime
+            }
+            getLastError();
+        }
+
+        void run(int t, int n){
+            int base = t * (seconds/n);
+            for (int i=0; i < seconds / n; i++){
+                findOne(t, BSON("x" << ((base+i)%503) << "y" << ((base+i)%509)));
+            }
+        }
+    };
+
+}
+*/
+
+static int userids[] = {
+  19455489, 5381772, 5701820, 5754058, 10876381, 5279698, 6130363, 6150116, 19368260, 19457933, 19457344,
+  19461626, 19460087, 19468439, 19471498, 19480617, 19488894, 19534335, 19542684, 19584682, 19642128, 1865666,
+  1851367, 5996532, 5139385, 5156629, 5180497, 5193466, 5313793, 5368017, 5374069, 5777830, 5517409, 5543195,
+  5631987, 5749877, 5875052, 5960534, 6014078, 6032225, 6033697, 6042999, 6054869, 6056953, 6061721, 6152341,
+  10930518, 10815503, 5305542, 5656610, 6097200, 19262825, 19430530, 19460833, 19484165, 19486131, 19486216,
+  19470329, 19473434, 19477845, 19484340, 19468227, 19491082, 19465018, 19475210, 19480370, 19484887, 19481308,
+  19524071, 19525107, 19523044, 19549779, 19566789, 19571543, 19591001, 19565545, 19622313, 19623234, 19607744,
+  19636836, 1862285, 703394, 762510, 761230, 5964600, 5272819, 5451372, 5993616, 5553594, 5743879, 5930071,
+  6078142, 5626619, 5262911, 5080634, 5109133, 5145545, 5175549, 5183400, 5202099, 5223949, 5293845, 5310342,
+  5313953, 5314923, 5346842, 5365646, 5382992, 5412741, 5414067, 5460185, 5466015, 5507624, 5552910, 5556613,
+  5566570, 5581125, 5611254, 5616810, 5627512, 5659487, 5665995, 5687388, 5698060, 5705066, 5716321, 5738754,
+  5747974, 5773013, 5782029, 5783917, 5809119, 5809598, 5830369, 5841450, 5850175, 5855878, 5867289, 5873944,
+  5875127, 5882234, 5912046, 5928831, 5949513, 5967876, 5973757, 5977662, 6011335, 6016486, 6037350, 6048204,
+  6090022, 6109023, 6152350, 10842433, 10894876, 5131479, 5589640, 5801160, 5947009, 6151093, 10812700, 10847949,
+  10848106, 10875217, 14209473, 6016112, 5297228, 5168087, 5205598, 5483321, 5252743, 5659936, 5697111, 5964392,
+  6126729, 6129525, 6147259, 6150967, 19279125, 19316933, 19408461, 19456273, 19430614, 19457846, 19461055,
+  19460472, 19459783, 19459820, 19460960, 19472964, 19489794, 19471851, 19476728, 19486590, 19483711, 19483504,
+  19480996, 19490337, 19486815, 19486720, 19490134, 19490824, 19465071, 19486503, 19486787, 19483645, 19489801,
+  19475499, 19467145, 19465930, 19463588, 19463753, 19470702, 19470827, 19467670, 19476429, 19474585, 19480254,
+  19479397, 19478401, 19477745, 19483573, 19482084, 19482118, 19481681, 19481342, 19487175, 19492168, 19491262,
+  19489820, 19489266, 19524500, 19522675, 19498000, 19494315, 19513811, 19517599, 19506799, 19504166, 19556622,
+  19550440, 19539017, 19555176, 19554888, 19557716, 19531969, 19561003, 19586202, 19590474, 19564687, 19570542,
+  19565195, 19587240, 19582965, 19591341, 19581870, 19600906, 19599117, 19605308, 19618747, 19622193, 19593570,
+  19622209, 19607217, 19623350, 19622821, 19625311, 19598992, 19653377, 19626978, 19632192, 19639692, 19649172,
+  19640637, 19631821, 19632736, 19632260, 19651459, 19649540, 19655146, 19654927, 19652514, 19629888, 12658,
+  1859137, 1866772, 1867627, 1850421, 2195431, 2196642, 19595500, 698977, 694913, 696531, 707688, 699189, 699224,
+  748804, 766384, 754784, 765009, 779270, 778280, 6128178, 14199358, 5424025, 5500389, 5345470, 6136177, 6072626,
+  5374094, 5348327, 5821083, 5829650, 5797758, 5770501, 5387479, 10847616, 6025659, 10869646, 5792764, 5331224,
+  5797735, 10845767, 5159803, 5861312, 6103909, 5708422, 5291410, 5075820, 10870196, 5378241, 6075888, 6051796,
+  5860247, 5261310, 5762915, 5845890, 5531363, 5981447, 5157842, 5758956, 5846161, 5077832, 5079905, 5080189,
+  5091536, 5092691, 5099202, 5101167, 5119235, 5145209, 5152923, 5158316, 5159709, 5160853, 5161458, 5171809,
+  5172973, 5176275, 5184879, 5194030, 5199809, 5201479, 5202181, 5203406, 5209544, 5215952, 5216860, 5217643,
+  5227613, 5230150, 5231773, 5233890, 5244923, 5246361, 5260515, 5263298, 5269271, 5273219, 5276604, 5280951,
+  5281704, 5283805, 5286734, 5291790, 5293197, 5294738, 5304232, 5307462, 5316174, 5319682, 5325920, 5339657,
+  5340013, 5340067, 5347366, 5355592, 5356845, 5359302, 5359982, 5360235, 5360326, 5360922, 5361339, 5367215,
+  5368315, 5371742, 5376226, 5377020, 5383694, 5383890, 5384829, 5390736, 5394298, 5395190, 5395193, 5397611,
+  5410450, 5410628, 5411635, 5581130, 5571493, 5474582, 6036667, 5711331, 5464844, 6110302, 5693510, 5417294,
+  5418586, 5418923, 5424500, 5425088, 5427567, 5433777, 5439533, 5440047, 5440870, 5447028, 5455880, 5458959,
+  5463818, 5464380, 5468671, 5468868, 5469239, 5473695, 5475999, 5478022, 5489925, 5497698, 5500647, 5500791,
+  5502899, 5502981, 5503109, 5506956, 5515654, 5525436, 5526007, 5527024, 5528163, 5528389, 5542513, 5547452,
+  5549007, 5551816, 5567258, 5572753, 5576758, 5580048, 5580553, 5583182, 5584008, 5585161, 5587541, 5588780,
+  5588982, 5592457, 5598318, 5603369, 5605317, 5607160, 5615687, 5616842, 5617707, 5620679, 5622710, 5622867,
+  5625267, 5628717, 5849973, 5634856, 5634955, 5638090, 5638270, 5638638, 5641407, 5641734, 5650178, 5650592,
+  5650601, 5661448, 5673059, 5674431, 5676038, 5680060, 5683914, 5689146, 5689561, 5695223, 5698031, 5700595,
+  5703525, 5705728, 5710803, 5714034, 5714108, 5719732, 5722924, 5732598, 5758643, 5761240, 5766655, 5774088,
+  5777134, 5779938, 5781723, 5783896, 5795937, 5796155, 5807080, 5808053, 5808930, 5817158, 5828844, 5829696,
+  5833765, 5835921, 5838918, 5843668, 5844483, 5848407, 5852020, 5858103, 5863974, 5866029, 5870436, 5875148,
+  5876798, 5882319, 5883883, 5884517, 5894257, 5897300, 5898649, 5911280, 5912611, 5914672, 5923499, 5924194,
+  5925854, 5929074, 5940136, 5947160, 5950297, 5951659, 5952243, 5958883, 5960304, 5965195, 5979799, 5980142,
+  5985731, 5987986, 5999497, 6002814, 6004400, 6006597, 6011030, 6011338, 6013784, 6030010, 6030791, 6033472,
+  6034955, 6036011, 6036254, 6039172, 6042677, 6043349, 6057708, 6064538, 6065159, 6066415, 6066801, 6068909,
+  6070412, 6070635, 6072739, 6076617, 6077155, 6077408, 6081856, 6094657, 6096344, 6098361, 6099843, 6099900,
+  6103653, 6112307, 6113048, 6114125, 6118547, 6123382, 6125191, 6127991, 6128159, 6128656, 6135000, 6137700,
+  6139012, 6142637, 6144525, 6145028, 6148856, 6149251, 6153492, 6166604, 6167666, 6168511, 10804260, 10809332,
+  10832518, 10833749, 10839485, 10847163, 10851553, 10893643, 10905933, 10913838, 10920605, 10936869, 5103172,
+  5263612, 5567663, 5596004, 5676569, 5707404, 5743537, 5800600, 5919465, 5952010, 5953799, 5955218, 5971574,
+  5986624, 6023933, 6042610, 6050102, 6051747, 6068192, 6078700, 6101250, 6149191, 6158449, 6170677, 5760618,
+  10807709, 10810905, 10818194, 10821574, 10823756, 10829484, 10832388, 10839435, 10853185, 10861244, 10866240,
+  10866370, 10866653, 10872761, 10877002, 10888104, 10890525, 10890886, 10891570, 10893415, 10897313, 10908865,
+  10918918, 10928832, 10930187, 10940366, 14208707, 5250473, 10807662, 10891818, 5324310, 5348322, 5409482,
+  5229785, 5814678, 10814491, 10819154, 10826159, 10849131, 10840525, 10837297, 10829038, 10878515, 10895638,
+  10893234, 10897418, 10910623, 10925127, 5473378, 5087930, 5093806, 5104117, 5137322, 5147662, 5152343, 5186475,
+  5196533, 5206699, 5221130, 5249253, 5270882, 5276681, 5308780, 5323710, 5326066, 5338018, 5337515, 5386754,
+  5428515, 5427860, 5436370, 5442775, 5471932, 5479092, 5484866, 5510605, 5525956, 5531050, 5560484, 5573746,
+  5581493, 5585552, 5605648, 5637731, 5638045, 5650510, 5660604, 5683519, 5692462, 5703468, 5730609, 5781849,
+  5781202, 5793186, 5817511, 5849077, 5877373, 5914305, 5920081, 5957880, 5957314, 5972804, 5979165, 5984197,
+  5994281, 6012157, 6036466, 6041440, 6075155, 6124029, 6141693, 6167230, 14226276, 15369087, 19245618, 19256981,
+  19255374, 19237120, 19256384, 19246328, 19240321, 19245401, 19227382, 19231241, 19231493, 19236009, 19235992,
+  19233082, 19233430, 19246627, 19255462, 19269216, 19288270, 19273862, 19259296, 19282374, 19278981, 19326603,
+  19322115, 19297717, 19300129, 19311961, 19315198, 19323960, 19363287, 19360840, 19376819, 19380535, 19389149,
+  19389213, 19370457, 19397636, 19418406, 19424611, 19425820, 19443798, 19450976, 19455250, 19454097, 19430166,
+  19436950, 19455116, 19437150, 19435917, 19433708, 19439617, 19439673, 19438059, 19446292, 19443533, 19442892,
+  19448243, 19447150, 19451264, 19458919, 19457822, 19456532, 19456066, 19456255, 19455888, 19462413, 19461979,
+  19460587, 19459700, 19451902, 19433627, 19435027, 19442564, 19447017, 19455143, 19430927, 19459719, 19441884,
+  19438798, 19448479, 19485623, 19490389, 19493688, 19491155, 19482054, 19482627, 19466365, 19492032, 19490298,
+  19479903, 19481758, 19467643, 19487017, 19481192, 19463348, 19467041, 19471363, 19470279, 19469930, 19468929,
+  19467534, 19476059, 19473459, 19472502, 19472339, 19480079, 19479657, 19477113, 19488943, 19487842, 19490566,
+  19489458, 19478569, 19473530, 19488787, 19493403, 19463129, 19473532, 19480711, 19484105, 19468882, 19471727,
+  19485033, 19489164, 19489645, 19483538, 19471110, 19471657, 19481891, 19481417, 19488316, 19481727, 19465226,
+  19476474, 19492777, 19493012, 19465585, 19466620, 19464919, 19465983, 19463089, 19479530, 19482735, 19483833,
+  19483030, 19481437, 19479541, 19484757, 19472875, 19470075, 19492814, 19486142, 19481725, 19464009, 19474161,
+  19466613, 19463391, 19462702, 19467376, 19466872, 19465582, 19465850, 19465155, 19464858, 19463897, 19471112,
+  19469741, 19469279, 19469467, 19468020, 19468022, 19475943, 19474502, 19474511, 19474718, 19473540, 19473059,
+  19473222, 19472715, 19472047, 19472187, 19472483, 19480045, 19480192, 19479211, 19479264, 19479362, 19477835,
+  19477866, 19484580, 19484882, 19484115, 19483928, 19482556, 19482912, 19482316, 19481881, 19481081, 19480788,
+  19480952, 19488555, 19488061, 19487531, 19487001, 19487154, 19486636, 19486995, 19486016, 19485677, 19491585,
+  19491831, 19491995, 19491387, 19491441, 19490650
+};
+
+OID venueids[] = {
+  OID("4e228599483b041af1f8994a"), OID("4e68e178ae60186280adbd11"), OID("4e482388183849317e8df0a8"),
+  OID("4c08d4167e3fc928c1e0f082"), OID("4c17fc751436a59323ab8c75"), OID("4e64c6aed164ddd5e6bfe8f1"),
+  OID("4c85976b77be76b04b41b776"), OID("4e10727822713f7d7bc81ca6"), OID("4b8c1444f964a5209abc32e3"),
+  OID("4bfe5e7fee20ef3b838a3c5e"), OID("4c18007f2cddb7137514831e"), OID("4c6eda32d97fa1438232f1ca"),
+  OID("4df40f7fae609e69dd9c111c"), OID("4e006ac17d8beaa1649c4ce8"), OID("4e3b3b1ab61cb577be5a06ec"),
+  OID("4c1cb4afb4e62d7f316ddb93"), OID("4b15507ef964a520aeb023e3"), OID("4bfa6d655317a5934196027f"),
+  OID("4b330432f964a5200d1725e3"), OID("4df90e321495b7db1b109908"), OID("4dc0172bf7b115b875d850f1"),
+  OID("4e3ff4037d8b0e9610894992"), OID("49e39fa6f964a520a2621fe3"), OID("4e252915ae6035bd16f32da1"),
+  OID("4be3c4fef07b0f47d4e4f843"), OID("4b744584f964a5208ad12de3"), OID("4bb627766edc76b01b7a301c"),
+  OID("4b53e7adf964a52060ae27e3"), OID("4b774467f964a5203c8d2ee3"), OID("4d48113353ebba7a41785bac"),
+  OID("4cbf6411ca4aa1cd66cd19b4"), OID("41253f00f964a5204b0c1fe3"), OID("4c73d4c93c26ef3be1d2e6d5"),
+  OID("4c1e4000eac020a1105e49c2"), OID("4a55c1f7f964a52046b41fe3"), OID("4b554f0ff964a5205ce127e3"),
+  OID("4c7ffb24e602b1f7fd8b857a"), OID("4bfe74f9bf6576b04eafaeb8"), OID("4e5b973c813034cf45e42a5f"),
+  OID("4b994c11f964a520057135e3"), OID("4cb48d14cbab236af126bf73"), OID("4d6cc24540fc8eec87f89eba"),
+  OID("4bc4aee4f8219c74cbb7b710"), OID("4d13aa9d2b1fa35dca8c4ab1"), OID("4e15eebad22d026fa772f42c"),
+  OID("4b12c9c5f964a5202f8e23e3"), OID("4b65e495f964a52097062be3"), OID("4c5727cb7329c9286d398e80"),
+  OID("4d163c98b15cb1f79ffdac21"), OID("4d4c3db22d0d8cfac470cd25"), OID("4d3ac39ecc48224b7f46404f"),
+  OID("4b01aa68f964a520664422e3"), OID("4de9fae01f6e3ddebdbf7d69"), OID("4c13e54c7f7f2d7f4cf1df68"),
+  OID("4c1913f24ff90f4788610f49"), OID("4d2c488c342d6dcb06b71dcb"), OID("4b058700f964a5208b7a22e3"),
+  OID("4e880121f5b9fed680cd87bd"), OID("4b6303a7f964a520b55d2ae3"), OID("4cf85031e8e254817bdfd662"),
+  OID("4c82749374d7b60cea4880d8"), OID("4dd381bd2271d21ebd3e0502"), OID("4b5672d5f964a520d11028e3"),
+  OID("4b0a8824f964a520dd2423e3"), OID("4baeae08f964a52020ce3be3"), OID("4e5eefc618a870f60f3386f7"),
+  OID("4c7c2aa720bb199c20292329"), OID("4b2b4ca4f964a520a2b524e3"), OID("4b5b47caf964a5200cf128e3"),
+  OID("4dea3248d164ef597ce39c03"), OID("4a406f30f964a52098a41fe3"), OID("4bcfd6d741b9ef3b9341f9e5"),
+  OID("3fd66200f964a520bbe61ee3"), OID("4c5005931886c9b6dce0fa27"), OID("4deaae1f88774880e323a487"),
+  OID("4e8db778d3e3720da3fbdb79"), OID("4ba5027af964a520eccf38e3"), OID("4b8827b5f964a52093e331e3"),
+  OID("4b44dbfcf964a52078fe25e3"), OID("4b9d90d4f964a520feb336e3"), OID("4c129682a5eb76b0ec74beb7"),
+  OID("4ce1c61c00166ea8223a4388"), OID("4c893b24ed0aa1439c0bb0f3"), OID("4e7f366a9a52594cdf7897ec"),
+  OID("4e7c497b45ddcbc91eac15a7"), OID("4be79e6de1b39521b41e21c1"), OID("4d46f1f01911a0932391f0d8"),
+  OID("4e56be3d18a81fe3e5f1aeb9"), OID("4e252a23d22df6f888772101"), OID("4cc0b364083a9c74fba73678"),
+  OID("4c24996ec11dc9b6cfa52524"), OID("4d8d930c3bfef04de3638486"), OID("4b3d7bcaf964a520c69425e3"),
+  OID("4b62e276f964a52040572ae3"), OID("4c0f0c667189c9283699d9b6"), OID("4b0588dff964a520d8dd22e3"),
+  OID("4b995fd0f964a520ae7635e3"), OID("4b4be91ef964a52010ab26e3"), OID("4d9e033da1ec8cfa95f3114a"),
+  OID("4c36129e3849c9289666bbb1"), OID("4c24deeb905a0f4750796060"), OID("4813c340f964a5204b4f1fe3"),
+  OID("4b4e7160f964a520eeed26e3"), OID("40b13b00f964a520a2f61ee3"), OID("4b6988f1f964a5204fa62be3"),
+  OID("4b7a2519f964a52078242fe3"), OID("4b19839ef964a520acde23e3"), OID("4c98e850671db60c5871bdf6"),
+  OID("4ddac24ed22d4dbc8c0bbd22"), OID("4dac2dfd5da3ba8a47b012db"), OID("4a8d54eef964a520760f20e3"),
+  OID("4b4b489df964a520709626e3"), OID("4c1b892e624b9c74ba9f1204"), OID("4da88c9381541df437bfd00b"),
+  OID("4b64bc16f964a52009cc2ae3"), OID("4cd4cb1c2944b1f7bf7059ec"), OID("4c4dabe251c2c9280016309d"),
+  OID("4d92b679b053b60c78857fcb"), OID("439530e7f964a520882b1fe3"), OID("4a997418f964a520672e20e3"),
+  OID("4dea287445dd3993a8833862"), OID("4aabf233f964a520195b20e3"), OID("4ba6b36df964a520f46939e3"),
+  OID("4caded9a2303a143347feaf0"), OID("4aebfa97f964a5202dc521e3"), OID("4e179c7752b123a586cef176"),
+  OID("4b5bebc0f964a5205a1d29e3"), OID("4d31c68f2e56236ab0ef15b4"), OID("4cbb5725dd41a35d889feda0"),
+  OID("4c2e63817cc0c9b6a2f7e99a"), OID("4b0a71d7f964a5201a2423e3"), OID("4b6b9d16f964a52094122ce3"),
+  OID("4c4b2b88712ac9288ad8896c"), OID("4c378df43849c92828ebbdb1"), OID("4e0cfc16d22d8582bdb11dd3"),
+  OID("4a970136f964a520eb2720e3"), OID("4c1be865b4e62d7fdf2eda93"), OID("4a71a12af964a5204ed91fe3"),
+  OID("4dcf0b14d4c065592f8f33a9"), OID("4e09fbb518a8382643c5f30c"), OID("4af5edc6f964a520f0fe21e3"),
+  OID("4c3c8fcd933b0f479235e421"), OID("4e4276971f6ec93e92549055"), OID("4b8fff9df964a520166f33e3"),
+  OID("4c34c4147cc0c9b63ee5f39a"), OID("4b093cd0f964a520db1423e3"), OID("4b4a420df964a520268126e3"),
+  OID("4c1be590b306c928fcf862b7"), OID("4b08baf5f964a520861123e3"), OID("4c3cff2817f2ef3bd94281f4"),
+  OID("4df4ff9081dc20cdb9af891e"), OID("4ade60ecf964a520747521e3"), OID("4e7e875d77c8c4fb96c4e32a"),
+  OID("4e8475b7c2ee9c188c1579a2"), OID("4c3613f6298e9c7497a507e3"), OID("4c14ad9077cea5935ffed060"),
+  OID("4bc2829eabf4952159b4c293"), OID("4bed35e29868a593f2045d46"), OID("4c74420966be6dcbb739bd0f"),
+  OID("4d99938ac19fb60cee8ec665"), OID("4adcdebcf964a5201b6221e3"), OID("49b15db9f964a520d5521fe3"),
+  OID("49e4b762f964a5201e631fe3"), OID("4baea9fff964a52067cc3be3"), OID("4e7ff9e4b80383b0e008c618"),
+  OID("4d112ed05f3376eb368a1386"), OID("4d07873b9d33a143e367cc78"), OID("4abf8dd7f964a520139120e3"),
+  OID("4ada3a78f964a520422021e3"), OID("4b6cb20cf964a520ea4c2ce3"), OID("4b9222d1f964a520dae833e3"),
+  OID("4bf944e2bb5176b0328c5bb2"), OID("4c488c0131e41b8dd4745035"), OID("4c0123e819d8c928a5508829"),
+  OID("4b439f6af964a5208fe425e3"), OID("4bd5021e6f64952164916eec"), OID("4b094ad8f964a520501523e3"),
+  OID("4e2c957052b1b8f1986da3ef"), OID("4b3bb4b3f964a520467925e3"), OID("4e39205eaeb72d065964b8af"),
+  OID("4b4258cff964a52016d225e3"), OID("4d70d062b48c236a417fd357"), OID("4dab13ec6a2303012f1b84ac"),
+  OID("4b60bb01f964a52047f629e3"), OID("4d7ba7dd7498a1cd892f6efc"), OID("4bb78e4eb35776b072c4c701"),
+  OID("4bf5d4245e800f47ba57e6d4"), OID("4b92cd1cf964a520171d34e3"), OID("4d835fa799b78cfab3d59e1f"),
+  OID("4e77be77fa769112d4fe6465"), OID("4ac3f607f964a520a79d20e3"), OID("4b16ad7ef964a520e4bb23e3"),
+  OID("4d9b2ec403d8721e96a3e124"), OID("4b82e25ef964a520e8ea30e3"), OID("4dfcdb54b61c84188eee403d"),
+  OID("4c9d1641d3c2b60cebd4bdbc"), OID("4cd44e0ea5b346885f2b8750"), OID("4ddace5c2271ac9047657a5f"),
+  OID("4b870349f964a52067ab31e3"), OID("4b312e7df964a520fc0125e3"), OID("4e8644f19adf376009a61900"),
+  OID("4c9356a5f600236ade70c432"), OID("4aedc915f964a520e2ce21e3"), OID("4b3bcdf1f964a520827b25e3"),
+  OID("4d150f8a8312236a8e824fba"), OID("4dc17e4e1838710f437ed107"), OID("4bd8d3132e6f0f47eccc0808"),
+  OID("4bd4c5226f649521a3196eec"), OID("4e58abea2271886714e89aad"), OID("4b9ab395f964a5206cce35e3"),
+  OID("4b65c9adf964a520bfff2ae3"), OID("4e57ded418a82d0a334c1eba"), OID("4a663032f964a5202fc81fe3"),
+  OID("4e826a4e77c85da056dd387b"), OID("4cd571fa122ba143e60b2ca1"), OID("4d658cdb6d943704cfaf78bf"),
+  OID("4540820cf964a5203c3c1fe3"), OID("4cb13eaff2dbef3b36dd79e5"), OID("4a3ecf0cf964a52075a31fe3"),
+  OID("4c55203afd2ea5937fdb312b"), OID("4ba3e7e1f964a520486c38e3"), OID("4c60fc9a1e5cd13a6a0ea3ed"),
+  OID("4b00400cf964a520f93b22e3"), OID("4be5bd27910020a15369d314"), OID("4bb7c509b35776b0ae26c801"),
+  OID("43c51016f964a520632d1fe3"), OID("4cb127fb39458cfa096909a0"), OID("4d4e7e034a38b60c0a7dea66"),
+  OID("4c8523bdd8086dcbe4fa8e52"), OID("4c88104f10523704098fbdf1"), OID("4bdfd3eb0ee3a593857a35b0"),
+  OID("4bff5fdfe584c9285e296e25"), OID("4b9c6605f964a520bb6536e3"), OID("4b58239df964a520f74b28e3"),
+  OID("4bb709be46d4a5938e0dc7c0"), OID("4c00e476ad15a59342938e73"), OID("4b671d69f964a520a13b2be3"),
+  OID("4bf08bf117880f47a3782937"), OID("4c9386d6533aa093669fb645"), OID("4b13f559f964a520f19a23e3"),
+  OID("4b9e5440f964a52064da36e3"), OID("4d9b551a7709cbff0c7e3ab2"), OID("4e53ff5a1495a46b65be98db"),
+  OID("481354f5f964a5203a4f1fe3"), OID("4c295c3be19720a1887af958"), OID("4d36f5e7d8caa1cd2b4d72d6"),
+  OID("4c9846df671db60cd144b8f6"), OID("4a43bcb7f964a520bba61fe3"), OID("4c6d73dde6b7b1f7cdc6a98e"),
+  OID("4dc30fe1ae608779d0ff7bda"), OID("4b6061cbf964a520dbe229e3"), OID("4c35ded5a0ced13a5a6d1a6e"),
+  OID("4ad4c00ef964a520f2ed20e3"), OID("4e2c0cb4b61cd010837b440d"), OID("4be533b8d4f7c9b6ee272520"),
+  OID("4be46c7c910020a1e0b1d114"), OID("4bf82e038d30d13a3d4b0018"), OID("4b87952cf964a52071c331e3"),
+  OID("4ec16d1cbe7b04923d264c7c"), OID("4b05b4c1f964a52047e122e3"), OID("4c8b9b752e3337042167ce41"),
+  OID("4b1a85c5f964a52097eb23e3"), OID("4b199d10f964a5207ee023e3"), OID("4bac6730f964a52095f33ae3"),
+  OID("4b166e4ef964a520fdb823e3"), OID("4af2dc2af964a520d0e821e3"), OID("4d08bd38611ff04dd77b1cfb"),
+  OID("4b6335bff964a520d16a2ae3"), OID("4ba55045f964a5208ff938e3"), OID("43a3c20df964a5203f2c1fe3"),
+  OID("4b8d6ad3f964a5206afa32e3"), OID("446d8fa5f964a52067331fe3"), OID("4b61c1fff964a520e1202ae3"),
+  OID("4c34f5823ffc95212e0a91f5"), OID("4b537a46f964a520f29e27e3"), OID("4d9e3cf714013704d7ad12b6"),
+  OID("4bb4402e87aa95216b0badd1"), OID("4b53f7ccf964a520baaf27e3"), OID("4b7b07b0f964a5204a4d2fe3"),
+  OID("4ae8be15f964a520e0b121e3"), OID("4cfab116c51fa1cdbd55e22b"), OID("4b4b1876f964a520389226e3"),
+  OID("4b529ebdf964a520218427e3"), OID("4b94a7aff964a520c07f34e3"), OID("4ba23ad0f964a5205de537e3"),
+  OID("4ba2e967f964a520162238e3"), OID("4412be02f964a520d6301fe3"), OID("4adcdb01f964a520ad5e21e3"),
+  OID("4c1dc0d0b4e62d7f3c55dd93"), OID("4adcdaa0f964a520a04d21e3"), OID("4b0b549ff964a520773023e3"),
+  OID("4addf02df964a5207d6621e3"), OID("4d733b64ff6ba35d59417a8a"), OID("4b2d0e1af964a52037cd24e3"),
+  OID("4b99bfc5f964a520e58f35e3"), OID("4c8cf4db5e048cfa0334d1cd"), OID("4ada5ad8f964a520bf2121e3"),
+  OID("49ca8f4df964a520b9581fe3"), OID("4b97ce38f964a520bb1635e3"), OID("4c572a546201e21e394a556e"),
+  OID("4ba3e14ff964a520936938e3"), OID("4bd9d9395f34b713a8df3579"), OID("4d3f8de546775481fc0050f4"),
+  OID("4ca8d8ef44a8224bdfc81b40"), OID("4d432f28f354236a8476796d"), OID("4d41462d00e8a35dca8802fb"),
+  OID("4e7251701f6ecfe82c35d18d"), OID("4dfcf57dd164848a03f780f3"), OID("4e2ce14ad22d3f83c89e8f5f"),
+  OID("4c5ecbba7f661b8d8af24e1c"), OID("4be497ce910020a15df1d114"), OID("4e30422f62e1fbac61137f70"),
+  OID("4c09aeb4ffb8c9b6786e6a61"), OID("4c09fd76009a0f476ac2e8bf"), OID("4e5139ecc65bb313ba9ea493"),
+  OID("4bb5b72e46d4a593a145c5c0"), OID("4e7f61d661af411b6306a7d5"), OID("4e604d9c2271573ad6ae7229"),
+  OID("4b525f22f964a520ea7927e3"), OID("4bfb45fdd0382d7fa188c90a"), OID("4b2c9a88f964a52014c824e3"),
+  OID("4e67b9cfae609d64bd03e867"), OID("4a0768b0f964a5205c731fe3"), OID("4b50f751f964a520f53a27e3"),
+  OID("4e7660f4cc3fc1186ed4599f"), OID("4d46cac61ed56dcbba6fc954"), OID("4b28eef1f964a520499624e3"),
+  OID("4e8a58d8be7b5e7d9602bcde"), OID("4e698e55a809290267a15df3"), OID("4c2e4501e307d13a65470fda"),
+  OID("4e99d3d6be7bc875aa3ebb7a"), OID("4d30af6982fd5481bca5b5a8"), OID("4bf1d84a99d02d7f7ea3c948"),
+  OID("4c336c206f1fef3b208aec3d"), OID("49c43671f964a520ae561fe3"), OID("4c617d2554ac0f47e10bb821"),
+  OID("4cd494a1122ba1434d6a26a1"), OID("45f412e6f964a520f6431fe3"), OID("4b6158ebf964a520af102ae3"),
+  OID("4c66b5e0b80abe9a96a8cde5"), OID("4bd5eca66f649521ccf66fec"), OID("4e246d9ad22d0a3f5a1571bf"),
+  OID("4c5aef82ec2520a104b75212"), OID("4d8b1ecd6ce6a35df7156e42"), OID("4e636dfbe4cdf1e2bfb7221d"),
+  OID("4cc952babcb1b1f7f8470e8a"), OID("4df75fa2aeb7da11e1a8a74e"), OID("4ce93b078ef78cfa37909f9b"),
+  OID("4d0610b992288eec008c9ce0"), OID("4e7bafdbae60ed9a4aafaa2b"), OID("4b4f0af6f964a52023f926e3"),
+  OID("4bad56adf964a520b5473be3"), OID("4dfa656c18a8ab1870be07a0"), OID("4e814d8d6da173f429b24d1c"),
+  OID("4bdb1dde63c5c9b6256b2668"), OID("4c9349bc911b8cfa2043f4b5"), OID("4bd054c677b29c74e07e8a82"),
+  OID("4c67b3a67abde21e59426768"), OID("4bdadc2063c5c9b6d1362568"), OID("4b8bc3aff964a5203caa32e3"),
+  OID("4ca35d3b7f84224b9e28c458"), OID("4bbe7a3782a2ef3b017d2bd2"), OID("4c2d6bc97d85a59399b252f3"),
+  OID("4b652435f964a52009e62ae3"), OID("4e899083be7b57d7d6e9eec2"), OID("4c7428dadb52b1f7574875dc"),
+  OID("4b677150f964a520394f2be3"), OID("4a36f332f964a5200c9e1fe3"), OID("4c38e2530a71c9b6508941c9"),
+  OID("4b6741a3f964a52034442be3"), OID("4e97aebe6c25f5286029d5cd"), OID("4c5ada266407d13a9b99b528"),
+  OID("4e02b3ebae6099b226e0a8ca"), OID("4df701ad483b96f73159134c"), OID("4e2abce352b1b8f1985935f1"),
+  OID("4dca4a9a183817362fdf2570"), OID("4b6159ccf964a520c7102ae3"), OID("4d678fb12433a143d40c4de0"),
+  OID("4a7dc82ef964a52098ef1fe3"), OID("4d0943ab9232236a6440c253"), OID("4c2b548b77cfe21e5247b4f1"),
+  OID("4c1e915ab306c928be4467b7"), OID("4b621f1df964a520d9362ae3"), OID("4b7b6d7af964a5201d632fe3"),
+  OID("4b565ebef964a5208c0d28e3"), OID("43c922c9f964a520972d1fe3"), OID("4dd557fe8877e2b7c5eeaecb"),
+  OID("4bd7225529eb9c74f94396e1"), OID("4bddd6cbe75c0f4765d0c503"), OID("4b269ac4f964a520367e24e3"),
+  OID("4a5ff47ff964a52090c01fe3"), OID("4b996ef9f964a5202d7b35e3"), OID("4bef2436f2712d7f9e5ffbd8"),
+  OID("4e5c0dc0b99329e22ae14682"), OID("413e4b80f964a520521c1fe3"), OID("4c3639101e06d13a96d9733e"),
+  OID("4cc36fbc91413704abfabb55"), OID("4e90950adab46521c1238498"), OID("4bcdb288fb84c9b67b60223e"),
+  OID("4bf343ed98ac0f4713c062a8"), OID("4ca2e52e5720b1f7d2302def"), OID("4dbd47e5a86e0e98a1f72d18"),
+  OID("4cd148ff6449a093041ccfcf"), OID("4d520d4ce02754819f0cb1b6"), OID("4cb3fed8c5e6a1cdd925f0f6"),
+  OID("4e689b8745dd6cc5bd0e2b0a"), OID("4cf3e2bb8333224b1d01188e"), OID("4b63406af964a520a36d2ae3"),
+  OID("4e930f1d8231bf0d17a4c2b7"), OID("4d2368ec2eb1f04d980008c2"), OID("4d07363830a58cfa783fafe7"),
+  OID("4b2ca711f964a52053c824e3"), OID("4e7aef0b6365723c65113a69"), OID("4d38747c3ffba143fcac5c56"),
+  OID("4b6dd554f964a52019942ce3"), OID("4e6617901838ad3d105c5f1f"), OID("4e298e4545ddfe8f9dfd264c"),
+  OID("4ea2087be3008f7d91ea8814"), OID("4b3110bef964a52073ff24e3"), OID("4bcf762a0ffdce72dc81b2c0"),
+  OID("4bb4564d49bdc9b64ab90c10"), OID("4b7f6ebff964a520552e30e3"), OID("4c79340abd346dcbd47ef4ef"),
+  OID("4c4b5aaf5609c9b615570391"), OID("4cc44d71d43ba143970266f8"), OID("4b99a2e8f964a520f38835e3"),
+  OID("4dfdf3cb7d8b30508019d0fa"), OID("4f4e9924e4b0f03ee60bb5dd"), OID("4f5b9ca0e4b0b28dd40cfa0c"),
+  OID("4acbc300f964a52058c520e3"), OID("4cb18feb39458cfab5670ca0"), OID("4b772338f964a5201d812ee3"),
+  OID("4c4535eb429a0f47a0e1491e"), OID("4b5d4c0cf964a5201f5929e3"), OID("4babbe56f964a52094c53ae3"),
+  OID("4c967d8438dd8cfa8cf9db62"), OID("4c1091a43ce120a1b452081c"), OID("4aa44e08f964a5204f4620e3"),
+  OID("4e8e4f94b8034831903baae9"), OID("4db588fd4df05e5aaaf43454"), OID("4bec61c2b68520a1ec081287"),
+  OID("4b5b1038f964a52094e128e3"), OID("4bb38b8f42959c74fb16222c"), OID("4bf328ca354e9c74c88d2602"),
+  OID("4e7a867ae4cdbba061cba356"), OID("446e0714f964a52075331fe3"), OID("4dea9aee7d8b6c7a53444996"),
+  OID("4b5270f4f964a520737d27e3"), OID("4c6e8f7ed5c3a1cd5591c82b"), OID("4b5ce66ef964a5200c4a29e3"),
+  OID("4e90179c2c5b7295bbb43f32"), OID("4bb41c28f187a593f1e913f8"), OID("4df8be7dae608a367cea8cbe"),
+  OID("4b45f75ef964a520141326e3"), OID("4e6fbc74aeb7e676a77de125"), OID("4e89ed78f790d7f88f3a1e68"),
+  OID("4bad1f39f964a520d52f3be3"), OID("4c6152ba54ac0f47519ab721"), OID("4b1168a6f964a520fb7b23e3"),
+  OID("4e92d0baa17cdc523bbf56d0"), OID("4c1b4deec09ed13a1a74828e"), OID("4e907bdc6c25abdcf4b6ba68"),
+  OID("47fd0d51f964a520da4e1fe3"), OID("4d9ab4a1674ca143e5a6c143"), OID("4b77064ff964a52088752ee3"),
+  OID("4b228c46f964a520cc4824e3"), OID("4d42404eb0c354812143def1"), OID("4c68980a773720a1831480e9"),
+  OID("4c51f13ab6dabe9a919e8b12"), OID("4c6009e523e303bb50d07407"), OID("4e427f7a18a8627fce4674c9"),
+  OID("4e987b3502d5a39437282663"), OID("4e3cbc41fa76455375af719e"), OID("4b3a1855f964a520026125e3"),
+  OID("4c8c4d0fc37a6dcba269f67a"), OID("4d100f5a71e8a1cd62977ebd"), OID("4e642825c65b2dc8a05fdbe3"),
+  OID("4dd72350d4c05d5096e31bb2"), OID("4d35ce8d98336dcb893545f0"), OID("4b5236eef964a5204d7027e3"),
   OID("4c5de5f4bfa59521465585ff"), OID("4b60f5fff964a520a5032ae3"), OID("47a89b73f964a520914d1fe3"),
   OID("4e6095e2c65b2dc89ecd60d5"), OID("4ca8732b14c33704d1f3d33b"), OID("4be8e22588ed2d7f7872cc1d"),
   OID("4b43b39cf964a520e8e625e3"), OID("4e9876ece5e883cc4ba95805"), OID("4b3f972af964a520c8a925e3"),
@@ -1084,74 +2585,1754 @@ OID venueids[] = {
   OID("4d1af9d3dd3637047d11601a"), OID("4bbf5a0185fbb713ec037267"), OID("4ba75f05f964a520c98e39e3")
 };
 
-namespace FSTests {
-    struct SimpleTest {
-        void reset() { }
+// Where the tests get their keys: the arrays above, or files given with
+// --user-ids (packed int64), --venue-ids (packed 12 byte OIDs) and
+// --uva-pairs (int64 user then OID venue). Files are mapped read-only and
+// shared by every thread, so startup doesn't grow with their size.
+namespace Keys {
+    struct Mapped {
+        Mapped() : data(0), n(0), stride(0) {}
+
+        void map(const string& path, size_t recordBytes) {
+            int fd = open(path.c_str(), O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)recordBytes) {
+                cout << "couldn't read keys from " << path << endl;
+                exit(1);
+            }
+            void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) {
+                cout << "couldn't map " << path << " : " << strerror(errno) << endl;
+                exit(1);
+            }
+            madvise(p, st.st_size, MADV_RANDOM); // keys are picked at random, don't read ahead
+            data = static_cast<const char*>(p);
+            stride = recordBytes;
+            n = st.st_size / recordBytes;
+        }
+
+        const char* record(long long i) const {
+            return data + size_t(i % n) * stride;
+        }
+
+        const char* data;
+        long long n; // 0 when not mapped
+        size_t stride;
+    };
+
+    Mapped users;
+    Mapped venues;
+    Mapped pairs;
+
+    // ids that fit go into BSON as ints, like the ones in the database
+    struct UserId {
+        long long id;
+    };
+
+    BSONObjBuilder& operator<<(BSONObjBuilderValueStream& s, UserId u) {
+        if (u.id == (int)u.id)
+            return s << (int)u.id;
+        return s << u.id;
+    }
+
+    void append(BSONArrayBuilder& a, UserId u) {
+        if (u.id == (int)u.id)
+            a.append((int)u.id);
+        else
+            a.append(u.id);
+    }
+
+    long long nUsers() {
+        return users.n ? users.n : sizeof(userids) / sizeof(int);
+    }
+
+    long long nVenues() {
+        return venues.n ? venues.n : sizeof(venueids) / sizeof(OID);
+    }
+
+    // without a pairs file, pair i is user i with venue i
+    long long nPairs() {
+        return pairs.n ? pairs.n : max(nUsers(), nVenues());
+    }
+
+    UserId user(long long i) {
+        UserId u;
+        if (users.n)
+            memcpy(&u.id, users.record(i), sizeof(u.id));
+        else
+            u.id = userids[i % nUsers()];
+        return u;
+    }
+
+    OID venue(long long i) {
+        if (!venues.n)
+            return venueids[i % nVenues()];
+        OID v;
+        memcpy(&v, venues.record(i), 12);
+        return v;
+    }
+
+    void pair(long long i, UserId& u, OID& v) {
+        if (!pairs.n) {
+            u = user(i);
+            v = venue(i);
+            return;
+        }
+        const char* r = pairs.record(i);
+        memcpy(&u.id, r, sizeof(u.id));
+        memcpy(&v, r + sizeof(u.id), 12);
+    }
+
+    // rand_r only gives 31 bits, not enough for 100M keys
+    long long random(unsigned& seed, long long n) {
+        return (((long long)rand_r(&seed) << 31) | rand_r(&seed)) % n;
+    }
+
+    // n users starting at first, wrapping around the end
+    BSONArray userRange(long long first, int n) {
+        BSONArrayBuilder a;
+        for (int i=0; i < n; i++)
+            append(a, user(first + i));
+        return a.arr();
+    }
+
+    BSONArray venueRange(long long first, int n) {
+        BSONArrayBuilder a;
+        for (int i=0; i < n; i++)
+            a.append(venue(first + i));
+        return a.arr();
+    }
+
+    // the users and the venues of n pairs
+    void pairRange(long long first, int n, BSONArray& us, BSONArray& vs) {
+        BSONArrayBuilder ua, va;
+        for (int i=0; i < n; i++){
+            UserId u;
+            OID v;
+            pair(first + i, u, v);
+            append(ua, u);
+            va.append(v);
+        }
+        us = ua.arr();
+        vs = va.arr();
+    }
+}
+
+namespace FSTests {
+    struct SimpleTest {
+        SimpleTest() {
+            for (int i=0; i < max_threads; i++)
+                seeds[i] = i;
+        }
+
+        void reset() { }
+        void teardown() { }
+        void report(BSONObjBuilder& round) { }
+        bool explainQuery(string& ns, Query& q) { return false; }
+        void finish(int threadId) {
+            if (pool_conns) return; // _conn[threadId] may be on loan, see runRound
+            try {
+                getLastError(threadId); //wait for operation to complete
+            }
+            catch (DBException&) {
+                reconnectIfFailed(threadId);
+            }
+        }
+
+        void run(int threadId, int seconds) {
+            const long long startTicks = FastClock::ticks();
+            const long long endTicks = startTicks + FastClock::fromMicros(seconds * 1000000LL);
+            const long long flushTicks = FastClock::fromMicros(flushMillis() * 1000LL);
+            long long nextFlush = startTicks + flushTicks;
+            long long opStart = startTicks;
+            LatencyHistogram hist;
+            LatencyHistogram waits;
+            Phases sampled;
+            Failures failed;
+            long long iters = 0;
+            long long flushed = 0;
+            int traceCountdown = tracer.sample;
+            long long maxMicros = 0;
+            long long lastProgress = roundStartTicks;
+            long long longestGap = 0;
+            while (opStart < endTicks) {
+                // pooled, the test's per-thread state goes with the
+                // connection: whoever holds conn is the only one using it
+                int conn = threadId;
+                if (pool_conns) {
+                    conn = pool.borrow();
+                    const long long borrowed = FastClock::ticks();
+                    waits.record(FastClock::toMicros(borrowed - opStart));
+                    opStart = borrowed;
+                }
+                const bool sample = phase_sample && iters % phase_sample == 0;
+                if (sample)
+                    _conn[conn].beginSample(FastClock::toMicros(opStart));
+                bool timedOut;
+                const bool ok = tryOp(boost::bind(&SimpleTest::oneIteration, this, conn), timedOut);
+                const long long opEnd = FastClock::ticks();
+                const long long micros = FastClock::toMicros(opEnd - opStart);
+                if (traceCountdown && --traceCountdown == 0) {
+                    tracer.record(threadId, conn, opStart, opEnd, !ok);
+                    traceCountdown = tracer.sample;
+                }
+                if (ok) {
+                    if (sample)
+                        _conn[conn].endSample(FastClock::toMicros(opEnd), sampled);
+                    hist.record(micros);
+                    ++iters;
+                    maxMicros = max(maxMicros, micros);
+                    longestGap = max(longestGap, opEnd - lastProgress);
+                    lastProgress = opEnd;
+                }
+                else {
+                    if (sample)
+                        _conn[conn].cancelSample();
+                    countFailure(failed, _conn[conn], micros, timedOut);
+                }
+                if (pool_conns)
+                    pool.giveBack(conn);
+                opStart = ok ? opEnd : FastClock::ticks(); // don't charge the reconnect to the next op
+
+                // publish every flushMillis() so soak checkpoints see running totals
+                if (opEnd >= nextFlush) {
+                    flush(iters - flushed, hist, waits, sampled, failed);
+                    flushed = iters;
+                    nextFlush = opEnd + flushTicks;
+                }
+            }
+            flush(iters - flushed, hist, waits, sampled, failed);
+
+            ThreadStats& stats = threadStats[threadId];
+            stats.ops = iters;
+            stats.maxMicros = maxMicros;
+            stats.longestGapMicros = FastClock::toMicros(max(longestGap, FastClock::ticks() - lastProgress));
+            stats.ran = true;
+        }
+
+        void flush(long long iters, LatencyHistogram& hist, LatencyHistogram& waits, Phases& sampled, Failures& failed) {
+            {
+              boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+              iterations += iters;
+              bytes += iters * bytesPerIteration();
+              latencies.merge(hist);
+              poolWaits.merge(waits);
+              phases.add(sampled);
+              failures.add(failed);
+            }
+            hist.clear();
+            waits.clear();
+            sampled = Phases();
+            failed = Failures();
+        }
+
+        virtual void oneIteration(int threadId) = 0;
+        // payload each iteration moves, reported as mb_per_sec when nonzero
+        virtual long long bytesPerIteration() { return 0; }
+        // how often run() publishes its counts
+        virtual int flushMillis() { return flush_millis; }
+
+        // for tests that pick keys at random, one rand_r seed per thread
+        PerThread<unsigned> seeds;
+    };
+
+    // picks its keys at random from Keys
+    struct KeyedTest : SimpleTest {
+        long long pick(int threadId, long long n) {
+            return Keys::random(seeds[threadId], n);
+        }
+    };
+
+    // as many users per $in as there are compiled-in ones
+    const int usersPerIn = sizeof(userids) / sizeof(int);
+
+    struct LookupUserByID : KeyedTest {
+        virtual void oneIteration(int threadId) {
+            findOne(threadId,
+                    "foursquare.users",
+                    BSON("_id" << Keys::user(pick(threadId, Keys::nUsers()))));
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = "foursquare.users";
+            q = BSON("_id" << Keys::user(0));
+            return true;
+        }
+    };
+
+    struct LookupUserByIDs : KeyedTest {
+        virtual void oneIteration(int threadId) {
+            queryAndExhaustCursor(threadId,
+                                  "foursquare.users",
+                                  BSON("_id" << BSON("$in" << Keys::userRange(pick(threadId, Keys::nUsers()), usersPerIn))));
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = "foursquare.users";
+            q = BSON("_id" << BSON("$in" << Keys::userRange(0, usersPerIn)));
+            return true;
+        }
+    };
+
+    struct LookupUserByIDsNoExhaust : KeyedTest {
+        virtual void oneIteration(int threadId) {
+            query(threadId,
+                  "foursquare.users",
+                  BSON("_id" << BSON("$in" << Keys::userRange(pick(threadId, Keys::nUsers()), usersPerIn))));
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = "foursquare.users";
+            q = BSON("_id" << BSON("$in" << Keys::userRange(0, usersPerIn)));
+            return true;
+        }
+    };
+
+    // the users and venues of 200 pairs
+    Query uvaQuery(long long first) {
+        BSONArray us, vs;
+        Keys::pairRange(first, 200, us, vs);
+        return BSON("_id.u" << BSON("$in" << us) <<
+                    "_id.v" << BSON("$in" << vs));
+    }
+
+    struct LookupUVAByUVDoubleInQuery : KeyedTest {
+        virtual void oneIteration(int threadId) {
+            const Query& q = uvaQuery(pick(threadId, Keys::nPairs()));
+            //cout << "uva query: " << q.toString() << endl;
+            query(threadId,
+                  "foursquare.user_venue_aggregations2",
+                   q
+                 );
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = "foursquare.user_venue_aggregations2";
+            q = uvaQuery(0);
+            return true;
+        }
+    };
+}
+
+namespace Overhead {
+    // Costs the harness adds around every operation. DoNothing is the bare
+    // loop: clock read, latency histogram and iteration accounting.
+    volatile long long sunk;
+
+    struct Base : FSTests::SimpleTest {
+        void finish(int threadId) { } // nothing was sent
+
+        void reset() { sink.clear(); }
+
+        // what the threads computed, so the compiler can't leave it out
+        void report(BSONObjBuilder& round) {
+            long long total = 0;
+            for (int i=0; i < max_threads; i++)
+                total += sink[i];
+            sunk = total;
+        }
+
+        PerThread<long long> sink;
+    };
+
+    struct DoNothing : Base {
+        virtual void oneIteration(int threadId) { }
+    };
+
+    struct ReadClock : Base {
+        virtual void oneIteration(int threadId) {
+            sink[threadId] += FastClock::ticks();
+        }
+    };
+
+    // what SimpleTest used to call on every iteration
+    struct ReadPosixClock : Base {
+        virtual void oneIteration(int threadId) {
+            boost::posix_time::microsec_clock::universal_time();
+        }
+    };
+
+    struct BuildBSON : Base {
+        virtual void oneIteration(int threadId) {
+            sink[threadId] += BSON("_id" << 19455489).objsize();
+        }
+    };
+
+    // the 200 x 200 query of LookupUVAByUVDoubleInQuery, without sending it
+    struct BuildDoubleInQuery : Base {
+        virtual void oneIteration(int threadId) {
+            sink[threadId] += FSTests::uvaQuery(threadId).obj.objsize();
+        }
+    };
+
+    // each thread counts as one op, so ops_per_sec is thread start-ups per second
+    struct ThreadStartup : Base {
+        void run(int threadId, int seconds) {
+            boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+            iterations++;
+        }
+        virtual void oneIteration(int threadId) { }
+    };
+
+    // ns per DoNothing iteration on one thread, reported with every round
+    double measure() {
+        DoNothing test;
+        iterations = 0;
+        latencies.clear();
+        roundStartTicks = FastClock::ticks();
+        test.run(0, 1);
+        return iterations ? 1e9 / iterations : 0;
+    }
+}
+
+namespace Sessions {
+    // Each virtual user is a stackless coroutine: a small struct holding where
+    // it is in the script. A scheduler thread resumes whichever user is due
+    // next, runs one step on the thread's connection, then parks the user for
+    // its think time. Thousands of users share each connection this way.
+    struct VirtualUser {
+        int step;
+        Keys::UserId userId;
+        OID venueId;
+        long long wakeMicros;
+        long long sessionStart;
+        long long busyMicros; // time spent in steps, think time excluded
+    };
+
+    struct Step {
+        const char* name;
+        void (*run)(int threadId, const VirtualUser& vu);
+    };
+
+    void lookupUser(int threadId, const VirtualUser& vu) {
+        findOne(threadId, "foursquare.users", BSON("_id" << vu.userId));
+    }
+
+    void lookupVenues(int threadId, const VirtualUser& vu) {
+        queryAndExhaustCursor(threadId, "foursquare.user_venue_aggregations2", BSON("_id.u" << vu.userId));
+    }
+
+    void writeCheckin(int threadId, const VirtualUser& vu) {
+        insert(threadId, "foursquare.checkins", BSON(GENOID << "u" << vu.userId << "v" << vu.venueId));
+        getLastError(threadId);
+    }
+
+    void upsertAggregation(int threadId, const VirtualUser& vu) {
+        update(threadId, "foursquare.user_venue_aggregations2",
+               BSON("_id" << BSON("u" << vu.userId << "v" << vu.venueId)),
+               BSON("$inc" << BSON("count" << 1)),
+               true);
+        getLastError(threadId);
+    }
+
+    const Step checkIn[] = {
+        {"LookupUser", lookupUser},
+        {"LookupUserVenues", lookupVenues},
+        {"WriteCheckin", writeCheckin},
+        {"UpsertAggregation", upsertAggregation},
+    };
+    const int nSteps = sizeof(checkIn) / sizeof(checkIn[0]);
+
+    struct Stats {
+        void merge(const Stats& other) {
+            sessions += other.sessions;
+            ops += other.ops;
+            session.merge(other.session);
+            sessionBusy.merge(other.sessionBusy);
+            lag.merge(other.lag);
+            for (int i=0; i < nSteps; i++)
+                steps[i].merge(other.steps[i]);
+            failed.add(other.failed);
+        }
+
+        Stats() : sessions(0), ops(0) {}
+        long long sessions;
+        long long ops;
+        Failures failed;               // steps that threw; the user starts a new session
+        LatencyHistogram session;      // first step start to last step end, think time included
+        LatencyHistogram sessionBusy;  // same, think time excluded
+        LatencyHistogram lag;          // how late users were resumed; grows once threads saturate
+        LatencyHistogram steps[nSteps];
+    };
+
+    // protected by _mutex
+    Stats totals;
+
+    long long thinkMicros(unsigned* seed) {
+        // exponential think times around the mean
+        double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+        return (long long)(-log(u) * think_ms * 1000);
+    }
+
+    void startSession(VirtualUser& vu, unsigned* seed) {
+        vu.step = 0;
+        Keys::pair(Keys::random(*seed, Keys::nPairs()), vu.userId, vu.venueId);
+        vu.busyMicros = 0;
+    }
+
+    void schedule(int threadId, int nUsers) {
+        typedef pair<long long, int> Wakeup; // wakeMicros, user index
+        priority_queue<Wakeup, vector<Wakeup>, greater<Wakeup> > due;
+        vector<VirtualUser> users(nUsers);
+        unsigned seed = threadId;
+        Stats stats;
+
+        const long long start = FastClock::micros();
+        const long long end = start + seconds * 1000000LL;
+        for (int i=0; i < nUsers; i++) {
+            startSession(users[i], &seed);
+            users[i].wakeMicros = start + thinkMicros(&seed); // stagger the first steps
+            due.push(Wakeup(users[i].wakeMicros, i));
+        }
+
+        while (!due.empty()) {
+            Wakeup next = due.top();
+            if (next.first >= end)
+                break;
+            long long now = FastClock::micros();
+            if (next.first > now) {
+                boost::this_thread::sleep(boost::posix_time::microseconds(next.first - now));
+                continue;
+            }
+            due.pop();
+
+            VirtualUser& vu = users[next.second];
+            stats.lag.record(now - vu.wakeMicros);
+            if (vu.step == 0)
+                vu.sessionStart = now;
+
+            bool timedOut;
+            const bool ok = tryOp(boost::bind(checkIn[vu.step].run, threadId, boost::cref(vu)), timedOut);
+            long long done = FastClock::micros();
+            if (!ok) {
+                countFailure(stats.failed, _conn[threadId], done - now, timedOut);
+                startSession(vu, &seed);
+                vu.wakeMicros = FastClock::micros() + thinkMicros(&seed);
+                due.push(Wakeup(vu.wakeMicros, next.second));
+                continue;
+            }
+            stats.steps[vu.step].record(done - now);
+            stats.ops++;
+            vu.busyMicros += done - now;
+
+            if (++vu.step == nSteps) {
+                stats.session.record(done - vu.sessionStart);
+                stats.sessionBusy.record(vu.busyMicros);
+                stats.sessions++;
+                startSession(vu, &seed);
+            }
+            vu.wakeMicros = done + thinkMicros(&seed);
+            due.push(Wakeup(vu.wakeMicros, next.second));
+        }
+
+        boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+        totals.merge(stats);
+    }
+
+    void run() {
+        const int nThreads = min(session_threads, max_threads - 1);
+        cerr << "########## Sessions::CheckIn " << sessions << " users on "
+             << nThreads << " connections ##########" << endl;
+
+        totals = Stats();
+        boost::thread_group threads;
+        for (int t=1; t <= nThreads; t++) {
+            // spread users evenly, the first threads take the remainder
+            int nUsers = sessions / nThreads + (t <= sessions % nThreads ? 1 : 0);
+            threads.create_thread(boost::bind(&schedule, t, nUsers));
+        }
+        threads.join_all();
+
+        BSONObjBuilder result;
+        result.append("time", double(seconds));
+        result.append("connections", nThreads);
+        result.append("think_ms", think_ms);
+        result.append("sessions", totals.sessions);
+        result.append("sessions_per_sec", double(totals.sessions) / seconds);
+        result.append("ops", totals.ops);
+        result.append("ops_per_sec", double(totals.ops) / seconds);
+        totals.failed.appendTo(result, totals.ops);
+        totals.session.appendTo(result);
+        {
+            BSONObjBuilder busy;
+            totals.sessionBusy.appendTo(busy);
+            result.append("session_busy", busy.obj());
+        }
+        {
+            BSONObjBuilder lag;
+            totals.lag.appendTo(lag);
+            result.append("schedule_lag", lag.obj());
+        }
+        BSONObjBuilder steps;
+        for (int i=0; i < nSteps; i++) {
+            BSONObjBuilder step;
+            step.append("ops", totals.steps[i].total);
+            totals.steps[i].appendTo(step);
+            steps.append(checkIn[i].name, step.obj());
+        }
+        result.append("steps", steps.obj());
+
+        BSONObjBuilder results;
+        results.append(BSONObjBuilder::numStr(sessions), result.obj());
+        BSONObj out =
+            BSON( "name" << "Sessions::CheckIn"
+               << "results" << results.obj()
+               );
+        cout << out.jsonString(Strict) << endl;
+    }
+}
+
+namespace DocShape {
+    const char* ns = "perf_docshape.docs";
+    const int datasetBytes = 16 * 1024 * 1024; // loaded for FindOne and FullScan
+    const int arenaBytes = 256 * 1024;         // per thread, for Insert
+
+    // Leaf fields hang off a chain of Depth-1 nested subobjects, each field
+    // padded so the whole document comes out near Bytes.
+    void appendShape(BSONObjBuilder& b, int fields, int valueBytes, int depth) {
+        if (depth > 1) {
+            BSONObjBuilder sub(b.subobjStart("n"));
+            appendShape(sub, fields, valueBytes, depth - 1);
+            sub.done();
+            return;
+        }
+        for (int f=0; f < fields; f++)
+            b.append("f" + BSONObjBuilder::numStr(f), string(valueBytes, 'x'));
+    }
+
+    // each field costs about 8 bytes of type, name and length besides its value
+    template <int Bytes, int Fields, int Depth>
+    BSONObj makeDoc(long long id) {
+        BSONObjBuilder b;
+        b.append("_id", int(id));
+        appendShape(b, Fields, max(0, (Bytes - 32) / Fields - 8), Depth);
+        return b.obj();
+    }
+
+    // no _id: the server assigns one so inserted documents can be reused
+    template <int Bytes, int Fields, int Depth>
+    BSONObj makeShape() {
+        BSONObjBuilder b;
+        appendShape(b, Fields, max(0, (Bytes - 32) / Fields - 8), Depth);
+        return b.obj();
+    }
+
+    // Pre-built documents for one thread, packed back to back in a single
+    // buffer before the thread starts timing, so only sending them is measured.
+    struct PayloadArena {
+        PayloadArena() : pos(0) {}
+
+        template <int Bytes, int Fields, int Depth>
+        void fill() {
+            BSONObj shape = makeShape<Bytes, Fields, Depth>();
+            const int count = max(4, min(64, arenaBytes / shape.objsize()));
+
+            buf.resize(size_t(count) * shape.objsize());
+            docs.clear();
+            for (int i=0; i < count; i++) {
+                char* slot = &buf[size_t(i) * shape.objsize()];
+                memcpy(slot, shape.objdata(), shape.objsize());
+                docs.push_back(BSONObj(slot));
+            }
+            pos = 0;
+        }
+
+        const BSONObj& next() {
+            return docs[pos++ % docs.size()];
+        }
+
+        void release() {
+            vector<BSONObj>().swap(docs);
+            vector<char>().swap(buf);
+        }
+
+        vector<char> buf;
+        vector<BSONObj> docs;
+        size_t pos;
+    };
+
+    template <int Bytes, int Fields, int Depth>
+    struct Insert : FSTests::SimpleTest {
+        void reset() {
+            _conn[0].dropCollection(ns);
+            docSize = makeShape<Bytes, Fields, Depth>().objsize();
+            // pooled, arenas go with the connections, so have them all ready up front
+            for (int c=1; c <= pool_conns; c++)
+                arenas[c].fill<Bytes, Fields, Depth>();
+        }
+
+        void run(int threadId, int seconds) {
+            if (!pool_conns)
+                arenas[threadId].fill<Bytes, Fields, Depth>();
+            FSTests::SimpleTest::run(threadId, seconds);
+            if (!pool_conns)
+                arenas[threadId].release();
+        }
+
+        virtual void oneIteration(int threadId) {
+            insert(threadId, ns, arenas[threadId].next());
+        }
+
+        virtual long long bytesPerIteration() { return docSize; }
+
+        PayloadArena arenas[max_threads];
+        int docSize;
+    };
+
+    // Loads datasetBytes worth of documents with _id 0..n-1 into a
+    // collection of their own, so Insert dropping ns leaves them be.
+    template <int Bytes, int Fields, int Depth>
+    struct LoadedBase : FSTests::SimpleTest {
+        LoadedBase()
+            : coll(string(ns) + "_" + BSONObjBuilder::numStr(Bytes) + "_" + BSONObjBuilder::numStr(Fields) + "_" + BSONObjBuilder::numStr(Depth)) {}
+
+        void reset() {
+            docSize = makeDoc<Bytes, Fields, Depth>(0).objsize();
+            nDocs = max(16, datasetBytes / docSize);
+            loadOnce(coll, nDocs, makeDoc<Bytes, Fields, Depth>); // rounds only read
+        }
+
+        const string coll;
+        int docSize;
+        int nDocs;
+    };
+
+    template <int Bytes, int Fields, int Depth>
+    struct FindOne : LoadedBase<Bytes, Fields, Depth> {
+        virtual void oneIteration(int threadId) {
+            findOne(threadId, this->coll, BSON("_id" << int(rand_r(&this->seeds[threadId]) % this->nDocs)));
+        }
+
+        virtual long long bytesPerIteration() { return this->docSize; }
+    };
+
+    template <int Bytes, int Fields, int Depth>
+    struct FullScan : LoadedBase<Bytes, Fields, Depth> {
+        virtual void oneIteration(int threadId) {
+            queryAndExhaustCursor(threadId, this->coll, BSONObj());
+        }
+
+        virtual long long bytesPerIteration() { return (long long)this->docSize * this->nDocs; }
+    };
+}
+
+namespace InScaling {
+    const char* usersNs = "perf_in.users";
+    const char* uvaNs = "perf_in.user_venue_aggregations2";
+    const int nUsers = 10000;
+    const int uvaKeys = 1000; // _id.u and _id.v both range over 0..999
+    const int venuesPerUser = 5;
+
+    BSONObj userDoc(long long i) {
+        return BSON("_id" << int(i));
+    }
+
+    // each user's venues spread over the whole range
+    BSONObj uvaDoc(long long i) {
+        const int u = int(i / venuesPerUser);
+        const int k = int(i % venuesPerUser);
+        return BSON("_id" << BSON("u" << u << "v" << (u * 7 + k * 131) % uvaKeys) << "count" << 1);
+    }
+
+    // shared by every test in the suite, nothing writes to it
+    void load() {
+        loadOnce(usersNs, nUsers, userDoc);
+        loadOnce(uvaNs, uvaKeys * venuesPerUser, uvaDoc);
+        _conn[0].ensureIndex(uvaNs, BSON("_id.u" << 1 << "_id.v" << 1));
+        getLastError(0);
+    }
+
+    vector<int> idRange(int base, int n) {
+        vector<int> ids(n);
+        for (int i=0; i < n; i++)
+            ids[i] = base + i;
+        return ids;
+    }
+
+    // every variant asks for the same contiguous block of ids starting at a
+    // random base, so they return the same documents
+    struct Base : FSTests::SimpleTest {
+        void reset() {
+            load();
+            docs.clear();
+        }
+
+        void report(BSONObjBuilder& round) {
+            docs.appendTo(round, "docs");
+        }
+
+        int randomBase(int threadId, int range, int n) {
+            return rand_r(&seeds[threadId]) % max(1, range - n + 1);
+        }
+
+        ResultCounts docs;
+    };
+
+    template <int N>
+    struct SingleIn : Base {
+        virtual void oneIteration(int threadId) {
+            int base = randomBase(threadId, nUsers, N);
+            auto_ptr<DBClientCursor> cursor = query(threadId, usersNs, BSON("_id" << BSON("$in" << idRange(base, N))));
+            docs.add(threadId, cursor->itcount());
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = usersNs;
+            q = BSON("_id" << BSON("$in" << idRange(0, N)));
+            return true;
+        }
+    };
+
+    template <int N>
+    struct SeparateFindOnes : Base {
+        virtual void oneIteration(int threadId) {
+            int base = randomBase(threadId, nUsers, N);
+            int found = 0;
+            for (int i=0; i < N; i++){
+                if (!_conn[threadId].findOne(usersNs, BSON("_id" << base + i)).isEmpty())
+                    found++;
+            }
+            docs.add(threadId, found);
+        }
+
+        // explains one of the N lookups
+        bool explainQuery(string& ns, Query& q) {
+            ns = usersNs;
+            q = BSON("_id" << 0);
+            return true;
+        }
+    };
+
+    template <int N>
+    struct RangeScan : Base {
+        virtual void oneIteration(int threadId) {
+            int base = randomBase(threadId, nUsers, N);
+            auto_ptr<DBClientCursor> cursor = query(threadId, usersNs, BSON("_id" << GTE << base << LT << base + N));
+            docs.add(threadId, cursor->itcount());
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = usersNs;
+            q = BSON("_id" << GTE << 0 << LT << N);
+            return true;
+        }
+    };
+
+    // U x V index bounds, like LookupUVAByUVDoubleInQuery's 200 x 200
+    template <int U, int V>
+    struct CompoundIn : Base {
+        virtual void oneIteration(int threadId) {
+            int ubase = randomBase(threadId, uvaKeys, U);
+            int vbase = randomBase(threadId, uvaKeys, V);
+            auto_ptr<DBClientCursor> cursor = query(threadId, uvaNs, BSON("_id.u" << BSON("$in" << idRange(ubase, U)) <<
+                                                                          "_id.v" << BSON("$in" << idRange(vbase, V))));
+            docs.add(threadId, cursor->itcount());
+        }
+
+        bool explainQuery(string& ns, Query& q) {
+            ns = uvaNs;
+            q = BSON("_id.u" << BSON("$in" << idRange(0, U)) <<
+                     "_id.v" << BSON("$in" << idRange(0, V)));
+            return true;
+        }
+    };
+}
+
+namespace WorkingSet {
+    const char* ns = "perf_workingset.docs";
+    const int docBytes = 4096; // about a page, so faults track documents touched
+
+    // sized to twice --ram-mb so the sweep can reach 200%
+    long long datasetDocs() {
+        return ram_mb * 2 * 1024LL * 1024 / docBytes;
+    }
+
+    BSONObj doc(long long i) {
+        static const string pad(docBytes - 64, 'x');
+        return BSON("_id" << i << "pad" << pad);
+    }
+
+    void load() {
+        loadOnce(ns, datasetDocs(), doc, 8);
+    }
+
+    // -1 when the server doesn't count them (mongos, mock_server, not linux)
+    long long pageFaults(const BSONObj& status) {
+        BSONElement faults = status.getObjectField("extra_info")["page_faults"];
+        return faults.isNumber() ? faults.numberLong() : -1;
+    }
+
+    // Uniform lookups over the first Percent of RAM worth of documents.
+    template <int Percent>
+    struct Lookup : FSTests::SimpleTest {
+        void reset() {
+            load();
+            if (!restart_cmd.empty())
+                restartServer();
+            nDocs = datasetDocs() * Percent / 200;
+            faultsBefore = pageFaults(serverStatus());
+        }
+
+        virtual void oneIteration(int threadId) {
+            long long id = (((long long)rand_r(&seeds[threadId]) << 31) | rand_r(&seeds[threadId])) % nDocs;
+            findOne(threadId, ns, BSON("_id" << id));
+        }
+
+        virtual long long bytesPerIteration() { return docBytes; }
+
+        void report(BSONObjBuilder& round) {
+            BSONObj status = serverStatus();
+            const long long faultsAfter = pageFaults(status);
+            round.append("working_set_mb", nDocs * docBytes / (1024 * 1024));
+            if (faultsBefore < 0 || faultsAfter < 0) {
+                round.appendNull("page_faults");
+                round.appendNull("faults_per_op");
+            }
+            else {
+                const long long faults = faultsAfter - faultsBefore;
+                round.append("page_faults", faults);
+                round.append("faults_per_op", iterations ? double(faults) / iterations : 0.0);
+            }
+            BSONElement resident = status.getObjectField("mem")["resident"];
+            if (resident.isNumber())
+                round.append("resident_mb", resident.numberLong());
+            else
+                round.appendNull("resident_mb");
+            round.append("cold_start", !restart_cmd.empty());
+        }
+
+        long long nDocs;
+        long long faultsBefore;
+    };
+}
+
+namespace Contention {
+    const char* ns = "perf_contention.user_venue_aggregations2";
+
+    // Zipfian ranks 0..n-1 with exponent theta, after Gray et al. "Quickly
+    // generating billion-record synthetic databases" as YCSB does it. Theta 0
+    // is uniform. Read-only once built; each thread passes its own seed.
+    struct Zipf {
+        Zipf() : n(0), theta(-1) {}
+
+        void init(long long keys, double skew) {
+            if (keys == n && skew == theta) return;
+            n = keys;
+            theta = skew;
+            zetan = 0;
+            for (long long i=1; i <= n; i++)
+                zetan += 1 / pow(double(i), theta);
+            const double zeta2 = 1 + pow(0.5, theta);
+            alpha = 1 / (1 - theta);
+            eta = (n > 2) ? (1 - pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan) : 1;
+        }
+
+        long long next(unsigned& seed) const {
+            const double u = rand_r(&seed) / (RAND_MAX + 1.0);
+            const double uz = u * zetan;
+            if (uz < 1) return 0;
+            if (uz < 1 + pow(0.5, theta)) return min(1LL, n - 1);
+            return min(n - 1, (long long)(n * pow(eta * u - eta + 1, alpha)));
+        }
+
+        long long n;
+        double theta;
+        double zetan;
+        double alpha;
+        double eta;
+    };
+
+    // $inc upserts on compound {u, v} ids over KeyCount documents, the hottest
+    // ranks scattered over the key space rather than next to each other.
+    // Grows also $pushes onto an array, so documents outgrow their padding
+    // and get moved instead of being updated in place.
+    template <int KeyCount, int ThetaPct, bool Grows>
+    struct Upsert : FSTests::SimpleTest {
+        void reset() {
+            _conn[0].dropCollection(ns);
+            zipf.init(KeyCount, ThetaPct / 100.0);
+            sampler.start();
+        }
+
+        virtual void oneIteration(int threadId) {
+            const long long key = zipf.next(seeds[threadId]) * 2654435761LL % KeyCount;
+            const BSONObj id = BSON("_id" << BSON("u" << int(key / 1000) << "v" << int(key % 1000)));
+            if (Grows)
+                update(threadId, ns, id, BSON("$inc" << BSON("count" << 1) << "$push" << BSON("checkins" << threadId)), true);
+            else
+                update(threadId, ns, id, BSON("$inc" << BSON("count" << 1)), true);
+        }
+
+        void teardown() {
+            sampler.stop();
+        }
+
+        void report(BSONObjBuilder& round) {
+            sampler.appendTo(round);
+
+            BSONObj stats;
+            _conn[0].runCommand("perf_contention", BSON("collStats" << "user_venue_aggregations2"), stats);
+            round.append("keys", KeyCount);
+            round.append("theta", ThetaPct / 100.0);
+            round.append("grows", Grows);
+            round.append("docs", stats["count"].numberLong());
+            round.append("padding_factor", stats["paddingFactor"].number());
+        }
+
+        Zipf zipf;
+        ServerSampler sampler;
+    };
+}
+
+namespace Geo {
+    const char* ns = "perf_geo.venues";
+    const int nVenues = 500000;
+    const int nCities = 100;
+    const double cityShare = 0.8;   // the rest is spread over the countryside
+    const double citySigma = 0.05;  // degrees, about 5km
+
+    // continental US, roughly
+    const double minLon = -125, maxLon = -70;
+    const double minLat = 25, maxLat = 49;
+
+    enum Where { Anywhere, City, Countryside };
+
+    struct Point {
+        double lon;
+        double lat;
+    };
+
+    double uniform(unsigned& seed) {
+        return rand_r(&seed) / (RAND_MAX + 1.0);
+    }
+
+    double gaussian(unsigned& seed) {
+        const double u = max(uniform(seed), 1e-12);
+        return sqrt(-2 * log(u)) * cos(2 * M_PI * uniform(seed));
+    }
+
+    // city i is 1/(i+1) as big as the largest one
+    struct Cities {
+        Cities() {
+            unsigned seed = 42;
+            double total = 0;
+            for (int i=0; i < nCities; i++){
+                Point c = { minLon + uniform(seed) * (maxLon - minLon), minLat + uniform(seed) * (maxLat - minLat) };
+                centers.push_back(c);
+                total += 1.0 / (i + 1);
+                cumulative.push_back(total);
+            }
+            for (int i=0; i < nCities; i++)
+                cumulative[i] /= total;
+        }
+
+        Point near(unsigned& seed) const {
+            const int i = lower_bound(cumulative.begin(), cumulative.end(), uniform(seed)) - cumulative.begin();
+            const Point& c = centers[min(i, nCities - 1)];
+            Point p = { c.lon + gaussian(seed) * citySigma, c.lat + gaussian(seed) * citySigma };
+            return p;
+        }
+
+        vector<Point> centers;
+        vector<double> cumulative;
+    };
+
+    const Cities& cities() {
+        static Cities c;
+        return c;
+    }
+
+    // venues and query points come from the same distribution
+    Point samplePoint(unsigned& seed, Where where) {
+        if (where == City || (where == Anywhere && uniform(seed) < cityShare))
+            return cities().near(seed);
+        Point p = { minLon + uniform(seed) * (maxLon - minLon), minLat + uniform(seed) * (maxLat - minLat) };
+        return p;
+    }
+
+    const char* whereName(Where where) {
+        return where == City ? "city" : where == Countryside ? "countryside" : "anywhere";
+    }
 
-        void run(int threadId, int seconds) {
-            boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
-            boost::posix_time::ptime endTime = startTime + boost::posix_time::seconds(seconds);
-            int iters = 0;
-            while (boost::posix_time::microsec_clock::universal_time() < endTime) {
-                oneIteration(threadId);
-                ++iters;
-            }
-            {
-              boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
-              iterations += iters;
-            }
+    // seeded from its _id so every run lays the venues out the same way
+    BSONObj venueDoc(long long i) {
+        unsigned seed = unsigned(i) * 2654435761u + 1;
+        Point p = samplePoint(seed, Anywhere);
+        return BSON("_id" << int(i) << "loc" << BSON_ARRAY(p.lon << p.lat) << "cat" << int(i % 10));
+    }
+
+    void load() {
+        loadOnce(ns, nVenues, venueDoc);
+        _conn[0].ensureIndex(ns, BSON("loc" << "2d"));
+        getLastError(0);
+    }
+
+    // counts the venues each query comes back with
+    template <int W>
+    struct Base : FSTests::SimpleTest {
+        void reset() {
+            load();
+            results.clear();
         }
 
-        virtual void oneIteration(int threadId) = 0;
+        void report(BSONObjBuilder& round) {
+            round.append("where", whereName(Where(W)));
+            results.appendTo(round, "results");
+        }
+
+        Point queryPoint(int threadId) {
+            return samplePoint(seeds[threadId], Where(W));
+        }
+
+        ResultCounts results;
     };
 
-    struct LookupUserByID : SimpleTest {
+    template <int Limit, int W>
+    struct Near : Base<W> {
         virtual void oneIteration(int threadId) {
-            findOne(threadId,
-                    "foursquare.users",
-                    BSON("_id" << 19455489));
+            Point p = this->queryPoint(threadId);
+            auto_ptr<DBClientCursor> cur = query(threadId, ns, BSON("loc" << BSON("$near" << BSON_ARRAY(p.lon << p.lat))), Limit);
+            this->results.add(threadId, cur->itcount());
         }
     };
 
-    struct LookupUserByIDs : SimpleTest {
+    // half the side of the box, in thousandths of a degree
+    template <int HalfMilliDeg, int W>
+    struct WithinBox : Base<W> {
         virtual void oneIteration(int threadId) {
-            queryAndExhaustCursor(threadId,
-                                  "foursquare.users",
-                                  BSON("_id" << BSON("$in" << vector<int>(userids, userids + (sizeof(userids) / sizeof(int))))));
+            Point p = this->queryPoint(threadId);
+            const double d = HalfMilliDeg / 1000.0;
+            BSONObj box = BSON_ARRAY(BSON_ARRAY(p.lon - d << p.lat - d) << BSON_ARRAY(p.lon + d << p.lat + d));
+            auto_ptr<DBClientCursor> cur = query(threadId, ns, BSON("loc" << BSON("$within" << BSON("$box" << box))));
+            this->results.add(threadId, cur->itcount());
         }
     };
 
-    struct LookupUserByIDsNoExhaust : SimpleTest {
+    template <int RadiusMilliDeg, int W>
+    struct WithinCenter : Base<W> {
         virtual void oneIteration(int threadId) {
-            query(threadId,
-                  "foursquare.users",
-                  BSON("_id" << BSON("$in" << vector<int>(userids, userids + (sizeof(userids) / sizeof(int))))));
+            Point p = this->queryPoint(threadId);
+            BSONObj center = BSON_ARRAY(BSON_ARRAY(p.lon << p.lat) << RadiusMilliDeg / 1000.0);
+            auto_ptr<DBClientCursor> cur = query(threadId, ns, BSON("loc" << BSON("$within" << BSON("$center" << center))));
+            this->results.add(threadId, cur->itcount());
         }
     };
 
-    struct LookupUVAByUVDoubleInQuery : SimpleTest {
+    template <int Num, int W>
+    struct GeoNearCommand : Base<W> {
         virtual void oneIteration(int threadId) {
-            const Query& q = BSON("_id.u" << BSON("$in" << vector<int>(userids, userids + 200)) <<
-                       "_id.v" << BSON("$in" << vector<OID>(venueids, venueids + 200)));
-            //cout << "uva query: " << q.toString() << endl;
-            query(threadId,
-                  "foursquare.user_venue_aggregations2",
-                   q
-                 );
+            Point p = this->queryPoint(threadId);
+            BSONObj info = command(_conn[threadId], "perf_geo", BSON("geoNear" << "venues" << "near" << BSON_ARRAY(p.lon << p.lat) << "num" << Num));
+            this->results.add(threadId, info["results"].eoo() ? 0 : info["results"].Obj().nFields());
+        }
+    };
+}
+
+namespace Analytics {
+    const char* db = "perf_analytics";
+
+    // user_venue_aggregations2-like documents: Docs/20 users with 20 venues
+    // each, a count and one of 10 categories
+    template <int Docs>
+    string collection() {
+        return "uva" + BSONObjBuilder::numStr(Docs);
+    }
+
+    template <int Docs>
+    string ns() {
+        return string(db) + "." + collection<Docs>();
+    }
+
+    BSONObj uvaId(int i) {
+        return BSON("u" << i / 20 << "v" << i % 20);
+    }
+
+    BSONObj doc(long long i) {
+        return BSON("_id" << uvaId(int(i)) << "count" << int(i % 100) << "cat" << int(i % 10));
+    }
+
+    template <int Docs>
+    void load() {
+        loadOnce(ns<Docs>(), Docs, doc);
+    }
+
+    // The reporting queries. Each one reads every document in the collection.
+    struct Idle {
+        static void run(DBClientConnection& conn, const string& coll) {
+            usleep(100 * 1000);
+        }
+    };
+
+    struct Count {
+        static void run(DBClientConnection& conn, const string& coll) {
+            conn.count(string(db) + "." + coll, BSON("count" << GTE << 50));
+        }
+    };
+
+    struct Distinct {
+        static void run(DBClientConnection& conn, const string& coll) {
+            command(conn, db, BSON("distinct" << coll << "key" << "_id.u"));
+        }
+    };
+
+    struct Group {
+        static void run(DBClientConnection& conn, const string& coll) {
+            BSONObjBuilder group;
+            group.append("ns", coll);
+            group.append("key", BSON("cat" << 1));
+            group.appendCode("$reduce", "function(doc, out){ out.total += doc.count; }");
+            group.append("initial", BSON("total" << 0));
+            command(conn, db, BSON("group" << group.obj()));
+        }
+    };
+
+    struct MapReduce {
+        static void run(DBClientConnection& conn, const string& coll) {
+            BSONObjBuilder mr;
+            mr.append("mapreduce", coll);
+            mr.appendCode("map", "function(){ emit(this.cat, this.count); }");
+            mr.appendCode("reduce", "function(key, values){ return Array.sum(values); }");
+            mr.append("out", BSON("inline" << 1));
+            command(conn, db, mr.obj());
+        }
+    };
+
+    // Every thread runs Op back to back. rows_per_sec counts the documents
+    // the server had to go through; memory is sampled while it runs.
+    template <typename Op, int Docs>
+    struct Command : FSTests::SimpleTest {
+        void reset() {
+            load<Docs>();
+            sampler.start();
+            start = FastClock::micros();
+        }
+
+        virtual void oneIteration(int threadId) {
+            Op::run(_conn[threadId], collection<Docs>());
+        }
+
+        void teardown() {
+            end = FastClock::micros();
+            sampler.stop();
+        }
+
+        void report(BSONObjBuilder& round) {
+            const double secs = (end - start) / 1000000.0;
+            sampler.appendTo(round);
+            round.append("docs", Docs);
+            round.append("rows_per_sec", secs ? (double)iterations * Docs / secs : 0.0);
+        }
+
+        ServerSampler sampler;
+        long long start;
+        long long end;
+    };
+
+    // Point lookups on every thread while one more connection runs Op over
+    // the same collection, for what reporting does to foreground latency.
+    // Idle is the baseline with nothing in the background.
+    template <typename Op, int Docs>
+    struct LookupsUnder : FSTests::SimpleTest {
+        LookupsUnder() : running(false) {}
+
+        void reset() {
+            load<Docs>();
+            sampler.start();
+            backgroundOps = 0;
+            backgroundFailed = Failures();
+            running = true;
+            background.reset(new boost::thread(boost::bind(&LookupsUnder::runBackground, this)));
+        }
+
+        virtual void oneIteration(int threadId) {
+            findOne(threadId, ns<Docs>(), BSON("_id" << uvaId(rand_r(&seeds[threadId]) % Docs)));
+        }
+
+        void teardown() {
+            running = false;
+            if (background) {
+                background->join();
+                background.reset();
+            }
+            sampler.stop();
+        }
+
+        void report(BSONObjBuilder& round) {
+            sampler.appendTo(round);
+            round.append("docs", Docs);
+            round.append("background_ops", backgroundOps);
+            BSONObjBuilder failed;
+            backgroundFailed.appendTo(failed, backgroundOps);
+            round.append("background_failures", failed.obj());
+        }
+
+        void runBackground() {
+            DBClientConnection conn;
+            string errmsg;
+            if (!conn.connect(targets[current_target], errmsg)) {
+                cerr << "couldn't connect for background load : " << errmsg << endl;
+                return;
+            }
+            while (running) {
+                const long long opStart = FastClock::micros();
+                bool timedOut;
+                if (tryOp(boost::bind(&Op::run, boost::ref(conn), collection<Docs>()), timedOut))
+                    backgroundOps++;
+                else
+                    countFailure(backgroundFailed, conn, FastClock::micros() - opStart, timedOut);
+            }
+        }
+
+        volatile bool running;
+        long long backgroundOps;
+        Failures backgroundFailed;
+        boost::scoped_ptr<boost::thread> background;
+        ServerSampler sampler;
+    };
+}
+
+namespace Interference {
+    // Readers run a suite test closed loop, as fast as they can. Writers
+    // upsert at a fixed total rate, open loop: each write is timed from
+    // when it was due, so a stalled server shows up as writer latency
+    // instead of quietly lowering the rate.
+    const char* ns = "perf_interference.writes";
+    const int writeKeys = 100000;
+    const int write_rates[] = {0, 100, 500, 1000, 2000, 5000, 10000, 20000}; // writes/sec, all writers together
+
+    // passed in as arguments
+    string reader_test = "FSTests::LookupUserByID";
+    int readers = 50;
+    int writers = 10;
+
+    // protect with _mutex
+    LatencyHistogram writeLatencies;
+    long long writes;
+    Failures writeFailures;
+
+    void writeOne(int threadId, int id) {
+        update(threadId, ns, BSON("_id" << id), BSON("$inc" << BSON("count" << 1)), true);
+        getLastError(threadId);
+    }
+
+    void paceWrites(int threadId, int rate, int seconds) {
+        const long long start = FastClock::ticks();
+        const long long end = start + FastClock::fromMicros(seconds * 1000000LL);
+        const long long interval = FastClock::fromMicros(1000000LL * writers / rate);
+        unsigned seed = threadId;
+        LatencyHistogram hist;
+        Failures failed;
+        long long done = 0;
+
+        // stagger the writers so they don't all fire together
+        for (long long due = start + interval * (threadId % writers) / writers; due < end; due += interval) {
+            long long now = FastClock::ticks();
+            if (due > now)
+                usleep(FastClock::toMicros(due - now));
+            const long long sent = FastClock::ticks();
+            bool timedOut;
+            const bool ok = tryOp(boost::bind(&writeOne, threadId, int(rand_r(&seed) % writeKeys)), timedOut);
+            const long long finished = FastClock::ticks();
+            if (ok) {
+                hist.record(FastClock::toMicros(finished - due));
+                done++;
+            }
+            else {
+                countFailure(failed, _conn[threadId], FastClock::toMicros(finished - sent), timedOut);
+            }
+        }
+
+        boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+        writeLatencies.merge(hist);
+        writes += done;
+        writeFailures.add(failed);
+    }
+
+    void run(TestBase* reader) {
+        const int nReaders = max(1, min(readers, max_threads - 1));
+        // writers keep their own connections, clear of any --pool
+        const int firstWriter = max(nReaders, pool_conns) + 1;
+        const int nWriters = min(writers, max_threads - firstWriter);
+        if (nWriters < 1) {
+            cout << "no connections left for writers" << endl;
+            return;
+        }
+        writers = nWriters;
+        cerr << "########## " << reader->name() << " under writes, " << nReaders << " readers, "
+             << nWriters << " writers ##########" << endl;
+
+        BSONObjBuilder results;
+        BOOST_FOREACH(int rate, write_rates){
+            iterations = 0;
+            bytes = 0;
+            latencies.clear();
+            phases = Phases();
+            failures = Failures();
+            writeLatencies.clear();
+            writes = 0;
+            writeFailures = Failures();
+            for (int t=0; t < max_threads; t++)
+                threadStats[t] = ThreadStats();
+            roundSeconds = seconds;
+            reader->reset();
+
+            boost::thread_group threads;
+            roundStartTicks = FastClock::ticks();
+            for (int t=1; t <= nReaders; t++)
+                threads.create_thread(boost::bind(&TestBase::run, reader, t, seconds));
+            for (int t=firstWriter; rate && t < firstWriter + nWriters; t++)
+                threads.create_thread(boost::bind(&paceWrites, t, rate, seconds));
+            threads.join_all();
+
+            BSONObjBuilder step;
+            step.append("ops", iterations);
+            step.append("ops_per_sec", double(iterations) / seconds);
+            latencies.appendTo(step);
+            failures.appendTo(step, iterations);
+            appendFairness(step, nReaders);
+            reader->teardown();
+            reader->report(step);
+            BSONObjBuilder w;
+            w.append("target_per_sec", rate);
+            w.append("writes", writes);
+            w.append("writes_per_sec", double(writes) / seconds);
+            writeLatencies.appendTo(w);
+            writeFailures.appendTo(w, writes);
+            step.append("writes", w.obj());
+            results.append(BSONObjBuilder::numStr(rate), step.obj());
+        }
+
+        BSONObj out =
+            BSON( "name" << reader->name()
+               << "interference" << BSON( "readers" << nReaders << "writers" << nWriters )
+               << "results" << results.obj()
+               );
+        cout << out.jsonString(Strict) << endl;
+    }
+}
+
+namespace Maintenance {
+    const char* db = "perf_maintenance";
+    const char* coll = "docs";
+    const char* ns = "perf_maintenance.docs";
+    const int nDocs = 500000;
+
+    BSONObj doc(long long i) {
+        static const string pad(200, 'x');
+        return BSON("_id" << int(i) << "count" << int(i % 100) << "pad" << pad);
+    }
+
+    void load() {
+        loadOnce(ns, nDocs, doc);
+    }
+
+    // a background build returns as soon as it starts, so watch currentOp for it
+    void waitForIndexBuilds(DBClientConnection& conn) {
+        const string indexes = string(db) + ".system.indexes";
+        while (true) {
+            BSONObj inprog = conn.findOne("admin.$cmd.sys.inprog", BSONObj());
+            bool building = false;
+            BOOST_FOREACH(BSONElement op, inprog["inprog"].Array()){
+                if (op.Obj()["ns"].str() == indexes)
+                    building = true;
+            }
+            if (!building)
+                return;
+            usleep(100 * 1000);
+        }
+    }
+
+    void checkLastError(DBClientConnection& conn) {
+        const string err = conn.getLastError();
+        if (!err.empty())
+            throw UserException(0, "ensureIndex failed: " + err);
+    }
+
+    // The operations, run on their own connection. prepare() puts the
+    // collection back the way the operation expects before every round.
+    // run() throws if the server refused or failed the operation.
+    struct EnsureIndex {
+        static void prepare() {
+            BSONObj info;
+            _conn[0].runCommand(db, BSON("dropIndexes" << coll << "index" << "count_1"), info);
+        }
+        static void run(DBClientConnection& conn) {
+            conn.ensureIndex(ns, BSON("count" << 1), false, "", false);
+            checkLastError(conn); // the index is built by the time this returns
         }
     };
+
+    struct EnsureIndexBackground {
+        static void prepare() {
+            EnsureIndex::prepare();
+        }
+        static void run(DBClientConnection& conn) {
+            conn.ensureIndex(ns, BSON("count" << 1), false, "", false, true);
+            checkLastError(conn);
+            waitForIndexBuilds(conn);
+        }
+    };
+
+    struct Compact {
+        static void prepare() { }
+        static void run(DBClientConnection& conn) {
+            command(conn, db, BSON("compact" << coll));
+        }
+    };
+
+    struct ReIndex {
+        static void prepare() { }
+        static void run(DBClientConnection& conn) {
+            command(conn, db, BSON("reIndex" << coll));
+        }
+    };
+
+    // what the workload did in one stretch of the round
+    struct Slice {
+        long long ops;
+        LatencyHistogram latencies;
+        long long at;
+
+        void take() {
+            boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+            ops = iterations;
+            latencies = ::latencies;
+            at = FastClock::micros();
+        }
+    };
+
+    // 80% _id lookups and 20% in-place $inc updates. A quarter of the way
+    // into the round Op starts on a side connection; the round is cut into
+    // before, during and after it.
+    template <typename Op>
+    struct UnderLoad : FSTests::SimpleTest {
+        void reset() {
+            load();
+            Op::prepare();
+            getLastError(0);
+            error.clear();
+            start.take();
+            controller.reset(new boost::thread(boost::bind(&UnderLoad::control, this)));
+        }
+
+        virtual void oneIteration(int threadId) {
+            const int id = rand_r(&seeds[threadId]) % nDocs;
+            if (id % 5)
+                findOne(threadId, ns, BSON("_id" << id));
+            else
+                update(threadId, ns, BSON("_id" << id), BSON("$inc" << BSON("count" << 1)));
+        }
+
+        void control() {
+            usleep(roundSeconds * 1000000LL / 4);
+            DBClientConnection conn;
+            string errmsg;
+            if (!conn.connect(targets[current_target], errmsg)) {
+                cerr << "couldn't connect for maintenance : " << errmsg << endl;
+                error = "couldn't connect : " + errmsg;
+                opStart = opEnd = start;
+                return;
+            }
+            opStart.take();
+            try {
+                Op::run(conn);
+            }
+            catch (DBException& e) {
+                cerr << "maintenance failed : " << e.what() << endl;
+                error = e.what();
+            }
+            opEnd.take();
+        }
+
+        // slices are cut from the running totals
+        virtual int flushMillis() { return 100; }
+
+        void teardown() {
+            if (controller) {
+                controller->join(); // may be after the workers, if it overran the round
+                controller.reset();
+            }
+        }
+
+        void report(BSONObjBuilder& round) {
+            round.append("maintenance_failed", !error.empty());
+            if (!error.empty())
+                round.append("maintenance_error", error);
+            Slice end;
+            end.take();
+
+            BSONObjBuilder slices;
+            appendSlice(slices, "before", start, opStart);
+            appendSlice(slices, "during", opStart, opEnd);
+            appendSlice(slices, "after", opEnd, end);
+            round.append("slices", slices.obj());
+
+            const double before = rate(start, opStart);
+            round.append("maintenance_secs", (opEnd.at - opStart.at) / 1000000.0);
+            round.append("maintenance_overran", opEnd.at >= end.at - 1000);
+            round.append("during_vs_before", before ? rate(opStart, opEnd) / before : 0.0);
+        }
+
+        static double rate(const Slice& from, const Slice& to) {
+            const double secs = (to.at - from.at) / 1000000.0;
+            return secs > 0 ? (to.ops - from.ops) / secs : 0.0;
+        }
+
+        static void appendSlice(BSONObjBuilder& b, const char* name, const Slice& from, const Slice& to) {
+            BSONObjBuilder s;
+            s.append("secs", (to.at - from.at) / 1000000.0);
+            s.append("ops", to.ops - from.ops);
+            s.append("ops_per_sec", rate(from, to));
+            to.latencies.since(from.latencies).appendTo(s);
+            b.append(name, s.obj());
+        }
+
+        Slice start;
+        Slice opStart;
+        Slice opEnd;
+        string error; // why Op didn't run to completion, if it didn't
+        boost::scoped_ptr<boost::thread> controller;
+    };
+}
+
+namespace Tailing {
+    const char* ns = "perf_tailing.feed";
+    const int docBytes = 256;
+
+    // Activity feed: the worker threads insert documents stamped with when
+    // they were sent into a capped collection, while Tailers more
+    // connections follow it with tailable await_data cursors and time how
+    // long each document took to reach them.
+    template <int Tailers, int CappedMb>
+    struct Feed : FSTests::SimpleTest {
+        Feed() : pad(docBytes - 64, 'x'), running(false) {}
+
+        void reset() {
+            _conn[0].dropCollection(ns);
+            _conn[0].createCollection(ns, CappedMb * 1024LL * 1024, true);
+            // a tailable cursor on an empty collection dies straight away
+            _conn[0].insert(ns, BSON("w" << -1 << "seq" << 0LL << "ts" << 0LL));
+            getLastError(0);
+
+            seqs.clear();
+            propagation.clear();
+            tailed = 0;
+            restarts = 0;
+            roundStart = FastClock::micros();
+            running = true;
+            tailers.reset(new boost::thread_group);
+            for (int i=0; i < Tailers; i++)
+                tailers->create_thread(boost::bind(&Feed::tail, this));
+        }
+
+        // Each connection numbers its own inserts. They reach the feed in
+        // that order, unlike the timestamps of several writers.
+        virtual void oneIteration(int threadId) {
+            insert(threadId, ns, BSON("w" << threadId << "seq" << ++seqs[threadId] << "ts" << FastClock::micros() << "pad" << pad));
+        }
+
+        virtual long long bytesPerIteration() { return docBytes; }
+
+        void tail() {
+            DBClientConnection conn;
+            string errmsg;
+            if (!conn.connect(targets[current_target], errmsg)) {
+                cerr << "tailer couldn't connect : " << errmsg << endl;
+                return;
+            }
+            LatencyHistogram hist;
+            long long seen = 0;
+            long long restarted = 0;
+            vector<long long> lastSeq(max_threads, 0); // by writer connection
+            int backoffMillis = 1;
+            while (running) {
+                // Starts from the oldest document still in the feed and skips
+                // what it has seen. Cursors only die when they run dry or the
+                // writers overwrite the document they're on.
+                bool returned = false;
+                try {
+                    auto_ptr<DBClientCursor> cursor = conn.query(ns, Query(), 0, 0, 0, QueryOption_CursorTailable | QueryOption_AwaitData);
+                    while (running && cursor.get() && !cursor->isDead()) {
+                        // blocks on the server for a while when there's nothing new
+                        while (running && cursor->more()) {
+                            BSONObj doc = cursor->next();
+                            returned = true;
+                            const int w = doc["w"].numberInt();
+                            const long long seq = doc["seq"].numberLong();
+                            if (w < 0 || w >= max_threads || seq <= lastSeq[w])
+                                continue;
+                            lastSeq[w] = seq;
+                            hist.record(FastClock::micros() - doc["ts"].numberLong());
+                            seen++;
+                        }
+                    }
+                }
+                catch (DBException& e) {
+                    reconnectIfFailed(conn);
+                }
+                if (!running)
+                    break;
+
+                // an overrun; anything else is a feed with nothing to read
+                if (returned) {
+                    restarted++;
+                    backoffMillis = 1;
+                }
+                usleep(backoffMillis * 1000);
+                if (!returned)
+                    backoffMillis = min(backoffMillis * 2, 1000);
+            }
+
+            boost::interprocess::scoped_lock<boost::signals2::mutex> lk(_mutex);
+            propagation.merge(hist);
+            tailed += seen;
+            restarts += restarted;
+        }
+
+        void teardown() {
+            roundEnd = FastClock::micros();
+            running = false;
+            if (tailers) {
+                tailers->join_all(); // each may sit in await_data for a couple of seconds
+                tailers.reset();
+            }
+        }
+
+        void report(BSONObjBuilder& round) {
+            const double secs = (roundEnd - roundStart) / 1000000.0;
+            round.append("tailers", Tailers);
+            round.append("capped_mb", CappedMb);
+            round.append("tailed", tailed);
+            round.append("tailed_per_sec", secs ? tailed / secs : 0.0);
+            round.append("tailed_per_sec_per_tailer", secs ? tailed / secs / Tailers : 0.0);
+            round.append("cursor_restarts", restarts);
+            BSONObjBuilder p;
+            propagation.appendTo(p);
+            round.append("propagation", p.obj());
+        }
+
+        const string pad;
+        PerThread<long long> seqs; // by connection, only its holder writes
+        volatile bool running;
+        long long roundStart;
+        long long roundEnd;
+        boost::scoped_ptr<boost::thread_group> tailers; // this round's
+        // protect with _mutex
+        LatencyHistogram propagation;
+        long long tailed;
+        long long restarts;
+    };
 }
 
 namespace{
     struct TheTestSuite : TestSuite{
-        TheTestSuite(){
+        TheTestSuite() : TestSuite("foursquare") {
           add<FSTests::LookupUserByID>();
           add<FSTests::LookupUserByIDs>();
           add<FSTests::LookupUserByIDsNoExhaust>();
           add<FSTests::LookupUVAByUVDoubleInQuery>();
         /*
-            //add< Overhead::DoNothing >();
-
             add< Insert::Empty >();
             add< Insert::EmptyBatched<2> >();
             add< Insert::EmptyBatched<10> >();
@@ -1189,28 +4370,356 @@ namespace{
        */
         }
     } theTestSuite;
+
+    struct OverheadSuite : TestSuite{
+        OverheadSuite() : TestSuite("overhead") {
+            add< Overhead::DoNothing >();
+            add< Overhead::ReadClock >();
+            add< Overhead::ReadPosixClock >();
+            add< Overhead::BuildBSON >();
+            add< Overhead::BuildDoubleInQuery >();
+            add< Overhead::ThreadStartup >();
+        }
+    } overheadSuite;
+
+    struct DocShapeSuite : TestSuite{
+        DocShapeSuite() : TestSuite("docshape") {
+            // size, 8 flat fields
+            add< DocShape::Insert<256, 8, 1> >();
+            add< DocShape::Insert<1024, 8, 1> >();
+            add< DocShape::Insert<4096, 8, 1> >();
+            add< DocShape::Insert<16384, 8, 1> >();
+            add< DocShape::Insert<131072, 8, 1> >();
+            add< DocShape::FindOne<256, 8, 1> >();
+            add< DocShape::FindOne<1024, 8, 1> >();
+            add< DocShape::FindOne<4096, 8, 1> >();
+            add< DocShape::FindOne<16384, 8, 1> >();
+            add< DocShape::FindOne<131072, 8, 1> >();
+            add< DocShape::FullScan<256, 8, 1> >();
+            add< DocShape::FullScan<1024, 8, 1> >();
+            add< DocShape::FullScan<4096, 8, 1> >();
+            add< DocShape::FullScan<16384, 8, 1> >();
+            add< DocShape::FullScan<131072, 8, 1> >();
+
+            // field count at 16k
+            add< DocShape::Insert<16384, 1, 1> >();
+            add< DocShape::Insert<16384, 64, 1> >();
+            add< DocShape::Insert<16384, 512, 1> >();
+            add< DocShape::FindOne<16384, 1, 1> >();
+            add< DocShape::FindOne<16384, 64, 1> >();
+            add< DocShape::FindOne<16384, 512, 1> >();
+            add< DocShape::FullScan<16384, 1, 1> >();
+            add< DocShape::FullScan<16384, 64, 1> >();
+            add< DocShape::FullScan<16384, 512, 1> >();
+
+            // nesting depth at 16k, 64 fields
+            add< DocShape::Insert<16384, 64, 4> >();
+            add< DocShape::Insert<16384, 64, 16> >();
+            add< DocShape::FindOne<16384, 64, 4> >();
+            add< DocShape::FindOne<16384, 64, 16> >();
+            add< DocShape::FullScan<16384, 64, 4> >();
+            add< DocShape::FullScan<16384, 64, 16> >();
+        }
+    } docShapeSuite;
+
+    struct InScalingSuite : TestSuite{
+        InScalingSuite() : TestSuite("in") {
+            add< InScaling::SingleIn<1> >();
+            add< InScaling::SingleIn<10> >();
+            add< InScaling::SingleIn<100> >();
+            add< InScaling::SingleIn<1000> >();
+            add< InScaling::SingleIn<5000> >();
+            add< InScaling::SeparateFindOnes<1> >();
+            add< InScaling::SeparateFindOnes<10> >();
+            add< InScaling::SeparateFindOnes<100> >();
+            add< InScaling::SeparateFindOnes<1000> >();
+            add< InScaling::SeparateFindOnes<5000> >();
+            add< InScaling::RangeScan<1> >();
+            add< InScaling::RangeScan<10> >();
+            add< InScaling::RangeScan<100> >();
+            add< InScaling::RangeScan<1000> >();
+            add< InScaling::RangeScan<5000> >();
+
+            // one dimension of the cross product at a time
+            add< InScaling::CompoundIn<1, 200> >();
+            add< InScaling::CompoundIn<10, 200> >();
+            add< InScaling::CompoundIn<100, 200> >();
+            add< InScaling::CompoundIn<200, 200> >();
+            add< InScaling::CompoundIn<1000, 200> >();
+            add< InScaling::CompoundIn<200, 1> >();
+            add< InScaling::CompoundIn<200, 10> >();
+            add< InScaling::CompoundIn<200, 100> >();
+            add< InScaling::CompoundIn<200, 1000> >();
+        }
+    } inScalingSuite;
+
+    struct WorkingSetSuite : TestSuite{
+        WorkingSetSuite() : TestSuite("workingset") {
+            add< WorkingSet::Lookup<10> >();
+            add< WorkingSet::Lookup<50> >();
+            add< WorkingSet::Lookup<100> >();
+            add< WorkingSet::Lookup<200> >();
+        }
+    } workingSetSuite;
+
+    struct ContentionSuite : TestSuite{
+        ContentionSuite() : TestSuite("contention") {
+            // number of distinct keys, uniform
+            add< Contention::Upsert<1, 0, false> >();
+            add< Contention::Upsert<100, 0, false> >();
+            add< Contention::Upsert<10000, 0, false> >();
+            add< Contention::Upsert<1000000, 0, false> >();
+
+            // skew over 1M keys
+            add< Contention::Upsert<1000000, 80, false> >();
+            add< Contention::Upsert<1000000, 99, false> >();
+
+            // documents that grow and move
+            add< Contention::Upsert<100, 0, true> >();
+            add< Contention::Upsert<10000, 0, true> >();
+            add< Contention::Upsert<1000000, 99, true> >();
+        }
+    } contentionSuite;
+
+    struct GeoSuite : TestSuite{
+        GeoSuite() : TestSuite("geo") {
+            // result size, query points anywhere
+            add< Geo::Near<10, Geo::Anywhere> >();
+            add< Geo::Near<100, Geo::Anywhere> >();
+            add< Geo::Near<1000, Geo::Anywhere> >();
+            add< Geo::WithinBox<10, Geo::Anywhere> >();
+            add< Geo::WithinBox<100, Geo::Anywhere> >();
+            add< Geo::WithinCenter<10, Geo::Anywhere> >();
+            add< Geo::WithinCenter<100, Geo::Anywhere> >();
+            add< Geo::GeoNearCommand<10, Geo::Anywhere> >();
+            add< Geo::GeoNearCommand<100, Geo::Anywhere> >();
+
+            // density: in a city vs out in the countryside
+            add< Geo::Near<10, Geo::City> >();
+            add< Geo::Near<10, Geo::Countryside> >();
+            add< Geo::WithinBox<100, Geo::City> >();
+            add< Geo::WithinBox<100, Geo::Countryside> >();
+            add< Geo::WithinCenter<100, Geo::City> >();
+            add< Geo::WithinCenter<100, Geo::Countryside> >();
+            add< Geo::GeoNearCommand<10, Geo::City> >();
+            add< Geo::GeoNearCommand<10, Geo::Countryside> >();
+        }
+    } geoSuite;
+
+    struct AnalyticsSuite : TestSuite{
+        AnalyticsSuite() : TestSuite("analytics") {
+            add< Analytics::Command<Analytics::Count, 10000> >();
+            add< Analytics::Command<Analytics::Count, 100000> >();
+            add< Analytics::Command<Analytics::Count, 1000000> >();
+            add< Analytics::Command<Analytics::Distinct, 10000> >();
+            add< Analytics::Command<Analytics::Distinct, 100000> >();
+            add< Analytics::Command<Analytics::Distinct, 1000000> >();
+            add< Analytics::Command<Analytics::Group, 10000> >();
+            add< Analytics::Command<Analytics::Group, 100000> >();
+            add< Analytics::Command<Analytics::Group, 1000000> >();
+            add< Analytics::Command<Analytics::MapReduce, 10000> >();
+            add< Analytics::Command<Analytics::MapReduce, 100000> >();
+            add< Analytics::Command<Analytics::MapReduce, 1000000> >();
+
+            // what each does to point lookups on the same collection
+            add< Analytics::LookupsUnder<Analytics::Idle, 1000000> >();
+            add< Analytics::LookupsUnder<Analytics::Count, 1000000> >();
+            add< Analytics::LookupsUnder<Analytics::Distinct, 1000000> >();
+            add< Analytics::LookupsUnder<Analytics::Group, 1000000> >();
+            add< Analytics::LookupsUnder<Analytics::MapReduce, 1000000> >();
+        }
+    } analyticsSuite;
+
+    struct MaintenanceSuite : TestSuite{
+        MaintenanceSuite() : TestSuite("maintenance") {
+            add< Maintenance::UnderLoad<Maintenance::EnsureIndex> >();
+            add< Maintenance::UnderLoad<Maintenance::EnsureIndexBackground> >();
+            add< Maintenance::UnderLoad<Maintenance::Compact> >();
+            add< Maintenance::UnderLoad<Maintenance::ReIndex> >();
+        }
+    } maintenanceSuite;
+
+    struct TailingSuite : TestSuite{
+        TailingSuite() : TestSuite("tailing") {
+            // number of tailers, 100MB feed
+            add< Tailing::Feed<1, 100> >();
+            add< Tailing::Feed<10, 100> >();
+            add< Tailing::Feed<50, 100> >();
+            add< Tailing::Feed<200, 100> >();
+
+            // feed size, 10 tailers
+            add< Tailing::Feed<10, 1> >();
+            add< Tailing::Feed<10, 10> >();
+            add< Tailing::Feed<10, 1000> >();
+        }
+    } tailingSuite;
 }
 
 int main(int argc, const char **argv){
-    if (argc < 3){
-        cout << argv[0] << " [host:port] [seconds] [multidb (1 or 0)]" << endl;
+    namespace po = boost::program_options;
+
+    string multidb;
+    string sweep;
+    string suite;
+    string trace_file;
+    int trace_sample;
+    string user_ids_file;
+    string venue_ids_file;
+    string uva_pairs_file;
+    double proxy_rtt_ms;
+    double proxy_jitter_ms;
+    double proxy_mbps;
+    int proxy_batch_us;
+
+    po::options_description options("options");
+    options.add_options()
+        ("help", "show this message")
+        ("host", po::value<string>(&host), "host:port to benchmark")
+        ("seconds", po::value<int>(&seconds), "seconds per round")
+        ("multidb", po::value<string>(&multidb)->default_value("0"), "use a separate db for each connection (1 or 0)")
+        ("sweep", po::value<string>(&sweep)->default_value("fixed"), "thread counts to run: fixed (1, 10, 20, 50, 100, 250, 500) or adaptive")
+        ("slo-p99", po::value<int>(&slo_p99_micros)->default_value(10000), "p99 latency SLO in micros for the adaptive sweep")
+        ("suite", po::value<string>(&suite)->default_value("foursquare"), "test suite to run: foursquare, overhead, docshape, in, workingset, contention, geo, analytics, maintenance or tailing")
+        ("phase-sample", po::value<int>(&phase_sample)->default_value(100), "break every Nth op into encode/send/wait/receive/decode phases, 0 to disable")
+        ("ram-mb", po::value<long long>(&ram_mb), "server RAM for the workingset suite (default: this box's)")
+        ("restart-cmd", po::value<string>(&restart_cmd), "shell command restarting the server cold before each workingset round")
+        ("soak-test", po::value<string>(&soak_test), "run only this test (e.g. FSTests::LookupUserByID) for --soak-hours, with a checkpoint line every --checkpoint-secs")
+        ("soak-hours", po::value<double>(&soak_hours)->default_value(8), "length of a soak run")
+        ("soak-threads", po::value<int>(&soak_threads)->default_value(100), "threads for a soak run")
+        ("checkpoint-secs", po::value<int>(&checkpoint_secs)->default_value(60), "seconds between soak checkpoints")
+        ("ab", po::value< vector<string> >(), "another host:port to compare against the first, round by round (repeatable)")
+        ("ab-pairs", po::value<int>(&ab_pairs)->default_value(5), "alternating rounds per target for each test and thread count in A/B mode")
+        ("ab-seconds", po::value<int>(&ab_seconds)->default_value(2), "seconds per A/B round")
+        ("op-timeout-ms", po::value<int>(&op_timeout_ms)->default_value(0), "socket timeout for every operation, 0 for none; failed connections are reconnected")
+        ("trace-file", po::value<string>(&trace_file), "write sampled operations of every round to this file in Chrome trace format")
+        ("trace-sample", po::value<int>(&trace_sample)->default_value(100), "trace every Nth operation of each thread")
+        ("proxy", "connect through a local proxy that emulates the network below")
+        ("proxy-rtt-ms", po::value<double>(&proxy_rtt_ms)->default_value(0), "round trip time the proxy adds")
+        ("proxy-jitter-ms", po::value<double>(&proxy_jitter_ms)->default_value(0), "up to this much extra delay each way")
+        ("proxy-mbps", po::value<double>(&proxy_mbps)->default_value(0), "bandwidth each way per connection, 0 for unlimited")
+        ("proxy-batch-us", po::value<int>(&proxy_batch_us)->default_value(0), "release data only on multiples of this many micros")
+        ("rtt-sweep", "run each test through the proxy at round trip times from 0.1ms to 50ms")
+        ("rtt-threads", po::value<int>(&rtt_threads)->default_value(50), "threads for --rtt-sweep")
+        ("interference", "sweep a fixed background write rate under closed-loop readers")
+        ("reader-test", po::value<string>(&Interference::reader_test)->default_value("FSTests::LookupUserByID"), "test the readers run in --interference mode")
+        ("readers", po::value<int>(&Interference::readers)->default_value(50), "reader threads for --interference")
+        ("writers", po::value<int>(&Interference::writers)->default_value(10), "writer threads for --interference")
+        ("pool", po::value<int>(&pool_conns)->default_value(0), "share this many connections among all the worker threads, which borrow one per operation")
+        ("user-ids", po::value<string>(&user_ids_file), "file of packed int64 user ids to use instead of the compiled-in ones")
+        ("venue-ids", po::value<string>(&venue_ids_file), "file of packed 12 byte venue OIDs to use instead of the compiled-in ones")
+        ("uva-pairs", po::value<string>(&uva_pairs_file), "file of packed (int64 user, OID venue) pairs for the user_venue_aggregations2 lookups")
+        ("sessions", po::value<int>(&sessions)->default_value(0), "run N check-in session virtual users instead of the test suite")
+        ("session-threads", po::value<int>(&session_threads)->default_value(50), "connections (and threads) the session users share")
+        ("think-ms", po::value<int>(&think_ms)->default_value(1000), "mean think time between session steps")
+        ;
+
+    po::positional_options_description positional;
+    positional.add("host", 1).add("seconds", 1).add("multidb", 1);
+
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch (po::error& e) {
+        cout << e.what() << endl;
         return 1;
     }
 
-    for (int i=0; i < max_threads; i++){
-        string errmsg;
-        if ( ! _conn[i].connect( string( argv[1] ), errmsg ) ) {
-            cout << "couldn't connect : " << errmsg << endl;
-            return 1;
-        }
+    if (vm.count("help") || !vm.count("host") || !vm.count("seconds") || (sweep != "fixed" && sweep != "adaptive") || !suites().count(suite)){
+        cout << argv[0] << " [host:port] [seconds] [multidb (1 or 0)] [options]" << endl;
+        cout << options << endl;
+        return 1;
+    }
+
+    targets.push_back(host);
+    if (vm.count("ab")) {
+        vector<string> ab = vm["ab"].as< vector<string> >();
+        targets.insert(targets.end(), ab.begin(), ab.end());
+    }
+    if ((int)targets.size() > max_targets) {
+        cout << "at most " << max_targets << " targets" << endl;
+        return 1;
+    }
+    if (ab_pairs < 2) {
+        cout << "--ab-pairs needs at least 2 pairs for a confidence interval" << endl;
+        return 1;
+    }
+
+    if (!user_ids_file.empty())
+        Keys::users.map(user_ids_file, 8);
+    if (!venue_ids_file.empty())
+        Keys::venues.map(venue_ids_file, 12);
+    if (!uva_pairs_file.empty())
+        Keys::pairs.map(uva_pairs_file, 8 + 12);
+
+    // before the proxy, which keeps time with it
+    FastClock::calibrate();
+
+    rtt_sweep_on = vm.count("rtt-sweep");
+    netem.enabled = vm.count("proxy") || rtt_sweep_on || proxy_rtt_ms || proxy_jitter_ms || proxy_mbps || proxy_batch_us;
+    if (netem.enabled) {
+        netem.rttMicros = int(proxy_rtt_ms * 1000);
+        netem.jitterMicros = int(proxy_jitter_ms * 1000);
+        netem.mbps = proxy_mbps;
+        netem.batchMicros = proxy_batch_us;
+        // every worker and side connection, with room for samplers, tailers and the like
+        raiseFileLimit(rlim_t(targets.size()) * (max_threads + 1) * 3 + 1024);
+        for (size_t t=0; t < targets.size(); t++)
+            targets[t] = proxies[t].start(targets[t]);
     }
 
-    seconds = atoi(argv[2]);
+    reconnectAll();
+
+    pool_conns = min(pool_conns, max_threads - 1);
+    if (pool_conns)
+        pool.init(pool_conns);
+
+    harness_overhead_ns = Overhead::measure();
+    cerr << "clock: " << FastClock::source() << ", harness overhead: " << harness_overhead_ns << "ns per iteration" << endl;
+
+    if (!trace_file.empty())
+        tracer.open(trace_file, trace_sample);
+
+    if (!ram_mb)
+        ram_mb = (long long)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+
+    multi_db = (multidb[0] == '1');
+    adaptive_sweep = (sweep == "adaptive");
+
+    if (!soak_test.empty()) {
+        for (map<string, TestSuite*>::iterator it=suites().begin(); it != suites().end(); ++it){
+            if (TestBase* test = it->second->find(soak_test)) {
+                it->second->soak(test);
+                tracer.close();
+                return 0;
+            }
+        }
+        cout << "no test named " << soak_test << endl;
+        return 1;
+    }
 
-    if (argc > 3)
-        multi_db = (argv[3][0] == '1');
+    if (vm.count("interference")) {
+        for (map<string, TestSuite*>::iterator it=suites().begin(); it != suites().end(); ++it){
+            if (TestBase* test = it->second->find(Interference::reader_test)) {
+                Interference::run(test);
+                tracer.close();
+                return 0;
+            }
+        }
+        cout << "no test named " << Interference::reader_test << endl;
+        return 1;
+    }
 
-    theTestSuite.run();
+    if (sessions)
+        Sessions::run();
+    else if (rtt_sweep_on)
+        suites()[suite]->rttSweep();
+    else if (targets.size() > 1)
+        suites()[suite]->compare();
+    else
+        suites()[suite]->run();
 
+    tracer.close();
     return 0;
 }
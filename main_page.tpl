@@ -29,7 +29,7 @@
     <form action="/">
         <label for="metric">Metric</label>
         <select name="metric">
-            %for m in ['ops_per_sec', 'time', 'speedup']:
+            %for m in ['ops_per_sec', 'time', 'speedup', 'p50_micros', 'p99_micros', 'error_rate']:
             <option {{"selected" if m == metric else ""}}>{{m}}</option>
             %end
         </select>
@@ -61,10 +61,10 @@
             %for i, result in enumerate(outer_result['results']):
             <tr>
                 <td>{{i}}</td>
-                <td>{{result['version']}}</td>
+                <td>{{result['version']}}{{' (plan changed)' if result['plan_changed'] else ''}}</td>
                 <td>{{result['date']}}</td>
                 %for thread in threads:
-                <td>{{result.get(str(thread), {metric:'--'})[metric]}}</td>
+                <td>{{result.get(str(thread), {}).get(metric, '--')}}</td>
                 %end
             </tr>
             %end
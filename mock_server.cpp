@@ -0,0 +1,257 @@
+#ifndef MONGO_EXPOSE_MACROS
+# define MONGO_EXPOSE_MACROS
+#endif
+
+#include <mongo/client/dbclient.h>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace std;
+using namespace mongo;
+
+// Stand-in for mongod that answers every request instantly (or after a fixed
+// delay) with canned replies. Pointing benchmark at it measures the ceiling of
+// the harness itself rather than the server.
+
+namespace {
+    // wire protocol opcodes (see db/dbmessage.h)
+    enum {
+        opReply = 1,
+        dbUpdate = 2001,
+        dbInsert = 2002,
+        dbQuery = 2004,
+        dbGetMore = 2005,
+        dbDelete = 2006,
+        dbKillCursors = 2007
+    };
+
+#pragma pack(1)
+    struct MsgHeader {
+        int messageLength;
+        int requestID;
+        int responseTo;
+        int opCode;
+    };
+
+    struct ReplyHeader {
+        MsgHeader header;
+        int responseFlags;
+        long long cursorID;
+        int startingFrom;
+        int numberReturned;
+    };
+#pragma pack()
+
+    // passed in as arguments
+    int reply_bytes = 100;
+    int latency_micros = 0;
+    int docs_per_reply = 1;
+    int getmore_batches = 0;
+
+    // prebuilt reply bodies, filled in before accepting connections
+    string one_doc;
+    string batch_docs;
+    string cmd_reply;
+
+    int request_id = 0;
+
+    void buildReplies() {
+        BSONObj doc = BSON( "_id" << 0 << "pad" << string(max(0, reply_bytes - 30), 'x') );
+        one_doc.assign(doc.objdata(), doc.objsize());
+
+        batch_docs.clear();
+        for (int i=0; i < docs_per_reply; i++)
+            batch_docs.append(doc.objdata(), doc.objsize());
+
+        // good enough for getlasterror, ismaster, ping and the rest
+        BSONObjBuilder b;
+        b.append("ismaster", true);
+        b.append("maxBsonObjectSize", 16 * 1024 * 1024);
+        b.appendNull("err");
+        b.append("n", 0);
+        b.append("ok", 1.0);
+        BSONObj cmd = b.obj();
+        cmd_reply.assign(cmd.objdata(), cmd.objsize());
+    }
+
+    bool readFully(int fd, char* buf, int len) {
+        while (len > 0) {
+            int ret = ::recv(fd, buf, len, 0);
+            if (ret <= 0) {
+                if (ret < 0 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            buf += ret;
+            len -= ret;
+        }
+        return true;
+    }
+
+    bool writeFully(int fd, const char* buf, int len) {
+        while (len > 0) {
+            int ret = ::send(fd, buf, len, MSG_NOSIGNAL);
+            if (ret < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            buf += ret;
+            len -= ret;
+        }
+        return true;
+    }
+
+    bool reply(int fd, vector<char>& out, int responseTo, long long cursorID,
+               int numberReturned, const string& docs) {
+        out.resize(sizeof(ReplyHeader) + docs.size());
+        ReplyHeader* r = reinterpret_cast<ReplyHeader*>(&out[0]);
+        r->header.messageLength = out.size();
+        r->header.requestID = __sync_add_and_fetch(&request_id, 1);
+        r->header.responseTo = responseTo;
+        r->header.opCode = opReply;
+        r->responseFlags = 0;
+        r->cursorID = cursorID;
+        r->startingFrom = 0;
+        r->numberReturned = numberReturned;
+        memcpy(&out[sizeof(ReplyHeader)], docs.data(), docs.size());
+
+        if (latency_micros)
+            usleep(latency_micros);
+
+        return writeFully(fd, &out[0], out.size());
+    }
+
+    // cursor ids just count down the number of getMore batches still to send
+    bool handleQuery(int fd, vector<char>& out, const MsgHeader* h, const char* body) {
+        const char* ns = body + sizeof(int); // skip flags
+        const char* p = ns + strlen(ns) + 1;
+        int nToReturn;
+        memcpy(&nToReturn, p + sizeof(int), sizeof(int));
+
+        size_t nsLen = strlen(ns);
+        if (nsLen >= 5 && strcmp(ns + nsLen - 5, "$cmd") == 0)
+            return reply(fd, out, h->requestID, 0, 1, cmd_reply);
+
+        // findOne asks for -1 (single batch, close cursor)
+        if (nToReturn == 1 || nToReturn == -1)
+            return reply(fd, out, h->requestID, 0, 1, one_doc);
+
+        return reply(fd, out, h->requestID, getmore_batches, docs_per_reply, batch_docs);
+    }
+
+    bool handleGetMore(int fd, vector<char>& out, const MsgHeader* h, const char* body) {
+        const char* ns = body + sizeof(int); // skip ZERO
+        const char* p = ns + strlen(ns) + 1 + sizeof(int); // skip numberToReturn
+        long long cursorID;
+        memcpy(&cursorID, p, sizeof(cursorID));
+
+        return reply(fd, out, h->requestID, max(0LL, cursorID - 1), docs_per_reply, batch_docs);
+    }
+
+    void serve(int fd) {
+        vector<char> in;
+        vector<char> out;
+
+        while (true) {
+            MsgHeader h;
+            if (!readFully(fd, reinterpret_cast<char*>(&h), sizeof(h)))
+                break;
+            if (h.messageLength < (int)sizeof(h) || h.messageLength > 48 * 1024 * 1024) {
+                cerr << "bad message length " << h.messageLength << endl;
+                break;
+            }
+
+            in.resize(h.messageLength - sizeof(h) + 1);
+            if (!readFully(fd, &in[0], h.messageLength - sizeof(h)))
+                break;
+
+            bool ok = true;
+            switch (h.opCode) {
+                case dbQuery:
+                    ok = handleQuery(fd, out, &h, &in[0]);
+                    break;
+                case dbGetMore:
+                    ok = handleGetMore(fd, out, &h, &in[0]);
+                    break;
+                case dbInsert:
+                case dbUpdate:
+                case dbDelete:
+                case dbKillCursors:
+                    // fire and forget, errors are reported through getlasterror
+                    break;
+                default:
+                    cerr << "unknown opCode " << h.opCode << endl;
+                    ok = false;
+            }
+            if (!ok)
+                break;
+        }
+
+        close(fd);
+    }
+}
+
+int main(int argc, const char **argv){
+    if (argc < 2){
+        cout << argv[0] << " [port] [reply bytes per doc] [latency micros] [docs per reply] [getmore batches]" << endl;
+        return 1;
+    }
+
+    int port = atoi(argv[1]);
+    if (argc > 2)
+        reply_bytes = atoi(argv[2]);
+    if (argc > 3)
+        latency_micros = atoi(argv[3]);
+    if (argc > 4)
+        docs_per_reply = max(1, atoi(argv[4]));
+    if (argc > 5)
+        getmore_batches = atoi(argv[5]);
+
+    buildReplies();
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 1024) != 0) {
+        cout << "couldn't listen on port " << port << " : " << strerror(errno) << endl;
+        return 1;
+    }
+
+    cerr << "mock server listening on " << port
+         << " (reply bytes: " << reply_bytes
+         << ", latency micros: " << latency_micros
+         << ", docs per reply: " << docs_per_reply
+         << ", getmore batches: " << getmore_batches << ")" << endl;
+
+    while (true) {
+        int fd = accept(listener, 0, 0);
+        if (fd < 0) {
+            if (errno != EINTR)
+                cerr << "accept failed : " << strerror(errno) << endl;
+            continue;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        boost::thread(boost::bind(&serve, fd)).detach();
+    }
+
+    return 0;
+}
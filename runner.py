@@ -18,19 +18,38 @@ optparser.add_option('-n', '--iterations', dest='iterations', help='number of it
 optparser.add_option('-s', '--mongos', dest='mongos', help='send all requests through mongos', action='store_true', default=False)
 optparser.add_option('--nolaunch', dest='nolaunch', help='use mongod already running on port', action='store_true', default=False)
 optparser.add_option('-m', '--multidb', dest='multidb', help='use a separate db for each connection', action='store_true', default=False)
+optparser.add_option('--mock', dest='mock', help='run against ./mock_server instead of mongod', action='store_true', default=False)
+optparser.add_option('--mock-args', dest='mock_args', help='extra args for mock_server: [reply bytes per doc] [latency micros] [docs per reply] [getmore batches]', type='string', default='')
+optparser.add_option('-a', '--bench-args', dest='bench_args', help='extra options for ./benchmark, e.g. "--sweep adaptive --slo-p99 5000"', type='string', default='')
+optparser.add_option('--cold-start', dest='cold_start', help='let benchmark restart mongod (and drop the page cache if root) before each workingset round', action='store_true', default=False)
+optparser.add_option('--plan-baseline', dest='plan_baseline', help='flag tests whose query plan differs from the latest run of this version', type='string', default=None)
 optparser.add_option('-l', '--label', dest='label', help='name to record', type='string', default='<git version>')
 
 (opts, versions) = optparser.parse_args()
 if not versions:
     versions = ['master']
 
-#TODO support multiple versions
+# the first version is the baseline, any others are run side by side with it
+# (on port+1, port+2, ...) and compared round by round with benchmark --ab
 branch = versions[0]
-mongodb_version = (branch if opts.label=='<git version>' else opts.label)
+mongodb_version = (' vs '.join(versions) if opts.label=='<git version>' else opts.label)
 mongodb_date = None
 
 mongod = None # set in following block
-if not opts.nolaunch:
+others = [] # mongods for versions[1:]
+pidfile = os.path.abspath('./tmp/mongod.pid')
+bench_args = opts.bench_args.split()
+if opts.mock:
+    if opts.label == '<git version>':
+        mongodb_version = 'mock'
+    mongodb_git = 'mock'
+
+    mongod = subprocess.Popen(['./mock_server', opts.port] + opts.mock_args.split())
+
+    print 'pid:', mongod.pid
+
+    time.sleep(1) # wait for server to start up
+elif not opts.nolaunch:
     if not os.path.exists('./tmp/mongo'):
         subprocess.check_call(['git', 'clone', 'http://github.com/mongodb/mongo.git'], cwd='./tmp')
     subprocess.check_call(['git', 'fetch'], cwd='./tmp/mongo')
@@ -47,19 +66,41 @@ if not opts.nolaunch:
     mongodb_git, mongodb_date = git_info.split(' ', 1)
 
     subprocess.check_call(['scons', 'mongod'], cwd='./tmp/mongo')
+    subprocess.check_call(['scons'], cwd='./tmp/mongo')
+    # ./tmp/mongo is checked out again for the other versions below
+    shutil.copy('./tmp/mongo/mongod', './tmp/mongod-0')
 
+    # the only launch of the baseline, so restarts and terminate() reach it
     if opts.mongos:
         mongod = subprocess.Popen(['simple-setup.py', '--path=./tmp/mongo', '--port='+opts.port])#, stdout=open(os.devnull))
         mongodb_version += '-mongos'
         mongodb_git += '-mongos'
+        print 'pid:', mongod.pid
+    elif opts.cold_start:
+        # forked so it survives being restarted by benchmark's --restart-cmd
+        start = './tmp/mongod-0 --quiet --dbpath ./tmp/data/ --port %s --fork --logpath ./tmp/mongod.log --pidfilepath %s' % (opts.port, pidfile)
+        subprocess.check_call(start, shell=True)
+        restart = 'kill `cat %s`; while kill -0 `cat %s` 2>/dev/null; do sleep 1; done; sync; (echo 3 > /proc/sys/vm/drop_caches) 2>/dev/null; %s' % (pidfile, pidfile, start)
+        bench_args += ['--restart-cmd', restart]
+        print 'pid:', open(pidfile).read().strip()
     else:
-        mongod = subprocess.Popen(['./tmp/mongo/mongod', '--quiet', '--dbpath', './tmp/data/', '--port', opts.port], stdout=open(os.devnull))
-
-    subprocess.check_call(['scons'], cwd='./tmp/mongo')
-
-    mongod = subprocess.Popen(['./tmp/mongo/mongod', '--quiet', '--dbpath', './tmp/data/', '--port', opts.port], stdout=open('/dev/null'))
-
-    print 'pid:', mongod.pid
+        mongod = subprocess.Popen(['./tmp/mongod-0', '--quiet', '--dbpath', './tmp/data/', '--port', opts.port], stdout=open('/dev/null'))
+        print 'pid:', mongod.pid
+
+    for i, other in enumerate(versions[1:], 1):
+        subprocess.check_call(['git', 'checkout', other], cwd='./tmp/mongo')
+        subprocess.check_call(['scons', 'mongod'], cwd='./tmp/mongo')
+        shutil.copy('./tmp/mongo/mongod', './tmp/mongod-%d' % i)
+        datadir = './tmp/data-%d/' % i
+        if os.path.exists(datadir):
+            shutil.rmtree(datadir)
+        os.mkdir(datadir)
+        port = str(int(opts.port) + i)
+        others.append(subprocess.Popen(['./tmp/mongod-%d' % i, '--quiet', '--dbpath', datadir, '--port', port], stdout=open('/dev/null')))
+        bench_args += ['--ab', '127.0.0.1:' + port]
+        git_info = subprocess.Popen(['git', 'log', '-1', '--pretty=format:%H'], cwd='./tmp/mongo', stdout=subprocess.PIPE).communicate()[0]
+        mongodb_git += ' vs ' + git_info
+        print 'pid:', others[-1].pid
 
     time.sleep(10) # wait for server to start up
 else:
@@ -68,18 +109,6 @@ else:
 if opts.label != '<git version>':
     mongodb_git = opts.label
 
-benchmark_results=''
-try:
-    multidb = '1' if opts.multidb else '0'
-    print "./benchmark %s %s %s" % (opts.port, opts.iterations, multidb)
-    benchmark = subprocess.Popen(['./benchmark', opts.port, opts.iterations, multidb], stdout=subprocess.PIPE)
-    benchmark_results = benchmark.communicate()[0]
-    time.sleep(1) # wait for server to clean up connections
-finally:
-    if mongod:
-        mongod.terminate()
-        mongod.wait()
-
 connection = None
 try:
     connection = pymongo.Connection()
@@ -87,21 +116,75 @@ try:
     results.ensure_index('mongodb_git')
     results.ensure_index('name')
     results.remove({'mongodb_git': mongodb_git})
+    soak = connection.bench_results.soak
+    soak.ensure_index([('mongodb_git', 1), ('name', 1), ('checkpoint', 1)])
+    soak.remove({'mongodb_git': mongodb_git})
+    ab = connection.bench_results.ab
+    ab.ensure_index([('mongodb_git', 1), ('name', 1)])
+    ab.remove({'mongodb_git': mongodb_git})
+    rtt = connection.bench_results.rtt
+    rtt.ensure_index([('mongodb_git', 1), ('name', 1)])
+    rtt.remove({'mongodb_git': mongodb_git})
+    interference = connection.bench_results.interference
+    interference.ensure_index([('mongodb_git', 1), ('name', 1)])
+    interference.remove({'mongodb_git': mongodb_git})
 except pymongo.errors.ConnectionFailure:
     pass
 
-
-for line in benchmark_results.split('\n'):
-    if line and not ('DBClientConnection::call' in line) and not ('mongo::MsgAssertionException' in line):
-        print line
+# thread counts at which the plan differs from the baseline version's
+def plan_changes(obj):
+    base = results.find_one({'name': obj['name'], 'mongodb_version': opts.plan_baseline}, sort=[('ran_at', -1)])
+    if not base:
+        return []
+    changed = []
+    for (n, res) in obj['results'].iteritems():
+        old = base['results'].get(n, {}).get('plan')
+        new = res.get('plan')
+        if old and new and any(old.get(f) != new.get(f) for f in ('cursor', 'nscanned', 'nscannedObjects', 'n')):
+            changed.append(n)
+    return sorted(changed, key=int)
+
+def record(line):
+    print line
+    # driver log lines are passed through, failures are counted in the results
+    if line.startswith('{'):
         obj = json.loads(line, object_hook=object_hook)
         obj['mongodb_version'] = mongodb_version
         obj['mongodb_date'] = mongodb_date
         obj['mongodb_git'] = mongodb_git
         obj['ran_at'] = datetime.datetime.now()
-        if connection: results.insert(obj)
-
-
-
-
+        if connection:
+            if 'checkpoint' in obj:
+                soak.insert(obj)
+            elif 'ab' in obj:
+                ab.insert(obj)
+            elif 'rtt_sweep' in obj:
+                rtt.insert(obj)
+            elif 'interference' in obj:
+                interference.insert(obj)
+            else:
+                if opts.plan_baseline:
+                    changed = plan_changes(obj)
+                    if changed:
+                        print 'plan changed from %s for %s at %s threads' % (opts.plan_baseline, obj['name'], ', '.join(changed))
+                        obj['plan_changed'] = changed
+                results.insert(obj)
 
+try:
+    multidb = '1' if opts.multidb else '0'
+    print "./benchmark %s %s %s %s" % (opts.port, opts.iterations, multidb, ' '.join(bench_args))
+    benchmark = subprocess.Popen(['./benchmark', opts.port, opts.iterations, multidb] + bench_args, stdout=subprocess.PIPE)
+    # record lines as they come so a long soak run keeps its checkpoints if it dies
+    for line in iter(benchmark.stdout.readline, ''):
+        record(line.strip())
+    benchmark.wait()
+    time.sleep(1) # wait for server to clean up connections
+finally:
+    if mongod:
+        mongod.terminate()
+        mongod.wait()
+    for other in others:
+        other.terminate()
+        other.wait()
+    if opts.cold_start and os.path.exists(pidfile):
+        subprocess.call('kill `cat %s`' % pidfile, shell=True)
@@ -33,7 +33,7 @@ def raw_data():
             name = result['name']
             results = []
 
-        row = dict(version=result['mongodb_version'], date=result['mongodb_date'])
+        row = dict(version=result['mongodb_version'], date=result['mongodb_date'], plan_changed=result.get('plan_changed', []))
         for (n, res) in result['results'].iteritems():
             row[n] = res
 
@@ -54,7 +54,7 @@ def main_page():
         out = []
         for i, result in enumerate(outer_result['results']):
             out.append({'label': result['version']
-                       ,'data': sorted([int(k), v[metric]] for (k,v) in result.iteritems() if k.isdigit())
+                       ,'data': sorted([int(k), v[metric]] for (k,v) in result.iteritems() if k.isdigit() and metric in v)
                        })
             threads.update(int(k) for k in result if k.isdigit())
         flot_results.append(json.dumps(out))